@@ -1,17 +1,20 @@
 /*
 v04 - PPM to USB Joystick
 
-Mapping:
-   Joystick.X            <->      (1)Aileron 
-   Joystick.Y            <->      (2)Eelev
-   Joystick.Xrotate      <->      (4)Rudder
-   Joystick.Yrotate      <->      (5)Gear
-   Joystick.sliderLeft   <->      (6)Ch6 (flaps)
-   Joystick.sliderRight  <->      (3)Throttle  
-   Joystick.button       <->      (7)Ch7
-   Joystick.button       <->      (8)Ch8 
-
- 
+Default mapping (see defaultMapping[] or upload a new table from the PC, src/ChannelMapper.h):
+   Axis X        <->      (1)Aileron 
+   Axis Y        <->      (2)Eelev
+   Axis Z        <->      (3)Throttle  
+   Axis Rx       <->      (4)Rudder
+   Axis Ry       <->      (5)Gear
+   Axis Rz       <->      (6)Ch6 (flaps)
+   Axis Slider   <->      (7)Ch7
+   Axis Dial     <->      (8)Ch8 
+   Axes 9..16    <->      (9..16)Ch9..Ch16 
+   Button 1      <->      (7)Ch7
+   Button 2      <->      (8)Ch8 
+   Hat           <->      not used  
+
 Original idea:  https://github.com/voroshkov/Leonardo-USB-RC-Adapter 
 USB HID library: https://github.com/arpruss/USBHID_stm32f1
 PPM Reader Library: https://github.com/i998/FlyByWire
@@ -19,6 +22,38 @@ PPM Reader Library: https://github.com/i998/FlyByWire
 Status:  Works OK
 
 Change list:
+v0.5:
+- added an optional trainer (buddy-box) input merged with the main PPM input, see ENABLE_TRAINER_INPUT
+- the sketch can be run on a PC with the virtual-time simulator, see extras/simulator 
+- custom HID joystick with up to 16 axes at 16 bits, configurable buttons and hats, 1ms polling interval
+- median filter window is a time budget (Filter.maxWindowTime), it adapts to the frame rate of the radio, 
+  the delay is half of the window and stays below half of the budget 
+- optional PPM output of the filtered channels (timer PWM + DMA), see ENABLE_PPM_OUTPUT
+- calibration and limits are compile time radio profiles, select the radio in src/RadioProfiles.h
+- signal statistics (per channel mean/variance/min/max/outliers, frame period, failsafe frames, rejected pulses) 
+  in a HID feature report, see src/SignalStats.h 
+- calibration mode: hold the Maple Mini button and move all sticks to their ends and let them rest at the centre, 
+  the endpoints and the centre of each channel are saved in the flash, see src/ChannelCalibration.h 
+- the mapping of channels to axes/buttons/hats is a table which can be uploaded from the PC with a HID feature report, 
+  with inversion, button thresholds with hysteresis and multi-position switches, see src/ChannelMapper.h 
+- warm start: the median filter starts with the first valid frame after boot and after a failsafe condition or a signal gap, 
+  boot to USB enumeration and boot to the first valid report times are in the diagnostics report 
+- signal loss watchdog (TIMER4): a lost signal is a failsafe condition within a frame period, 
+  the channels are held, centred or the throttle is cut (ppm.signalLossPolicy) at their calibrated values, 
+  see applySignalLossPolicy() 
+- optional dual-edge capture (ENABLE_DUAL_EDGE_CAPTURE): the polarity is detected automatically, 
+  channels are timed from both edges of the separators and noise spikes are rejected by the separator width 
+- memory monitor: stack high-water mark (painted stack), stack depth of the loop, the pipeline and 
+  (ENABLE_STACK_SAMPLES) of the interrupts through the PPMReader/PPMWriter hooks, 
+  static/heap size and RAM per module in a HID feature report, see src/MemoryMonitor.h and extras/tools/memory_map.py 
+- optional fractional axes (ENABLE_FRACTIONAL_OUTPUT): the trimmed mean of the filter window in 1/16 us is mapped 
+  to the axes, so a slow stick movement is not stair-stepped at 1 us 
+- optional deferred processing (ENABLE_DEFERRED_PROCESSING): the edge interrupts only queue the edge times, 
+  frames are decoded, filtered and mapped in a low priority software interrupt (PendSV) and loop() only hands 
+  the report to USB; latency from the edge to each stage in the diagnostics report, see src/FrameScheduler.h 
+- frame queue: complete frames are queued by PPMReader and taken in one pass, the older ones go through 
+  the filter and the statistics, so a late loop() does not skip frames in the filter history 
+  (the trainer input still takes the latest frame of each input) 
 v0.4:
 - bugfix - variable type mismatch
 v0.3:
@@ -59,8 +94,17 @@ included in all copies or substantial portions of the Software.
 #include <USBComposite.h>
 
 //use local copies of the libraries 
-#include "src\PPMReader.h"
-#include "src\MedianFilter.h"
+#include "src/PPMReader.h"
+#include "src/MedianFilter.h"
+#include "src/PPMMerger.h"
+#include "src/JoystickReport.h"
+#include "src/RadioProfiles.h"
+#include "src/PPMWriter.h"
+#include "src/SignalStats.h"
+#include "src/ChannelCalibration.h"
+#include "src/ChannelMapper.h"
+#include "src/MemoryMonitor.h"
+#include "src/FrameScheduler.h"
 
 
 
@@ -69,27 +113,55 @@ included in all copies or substantial portions of the Software.
 //so the USB Joystick wil not be available - the PC will detect a serial port instead.
 //#define ENABLE_DEBUG_LOOP_IN
 
+//Uncomment to read a second PPM signal (trainer / buddy-box) on PPMtrainerPin.
+//The instructor is on the main input, the student flies while the instructor holds
+//the trainer switch on trainerSwitchChannel. If one of the inputs is lost the other one takes over.
+//#define ENABLE_TRAINER_INPUT
+
+//Uncomment to output the filtered channels as a PPM signal on pin 5 (PA6),
+//e.g. for a trainer port or a second device 
+//#define ENABLE_PPM_OUTPUT
+
+//Uncomment to capture both edges of the PPM input: the signal polarity is detected automatically and 
+//each channel is timed from both edges of the separator pulses, so the interrupt latency jitter is averaged 
+//#define ENABLE_DUAL_EDGE_CAPTURE
+
+//Uncomment to drive the joystick axes with the trimmed mean of the filter window in 1/16 us 
+//instead of the median in whole microseconds, see src/MedianFilter.h 
+//#define ENABLE_FRACTIONAL_OUTPUT
+
+//Uncomment to decode, filter and map the frames in a low priority software interrupt (PendSV) as soon as 
+//a frame is complete, loop() only hands the finished report to USB, see src/FrameScheduler.h 
+//#define ENABLE_DEFERRED_PROCESSING
+
+//Uncomment to sample the stack pointer in the edge, watchdog and PPM output interrupts for the memory monitor. 
+//It is a call per edge, so it is off by default; the painted high-water mark covers the interrupts anyway 
+//#define ENABLE_STACK_SAMPLES
+
 
 //====Constants and global Variables==========================
 //the number of the LED pin
 const uint8_t ledPin =  LED_BUILTIN;
 
-//RC input channel parameters, microseconds  
-uint16_t minNormalChannelValue = 1100;
-uint16_t maxNormalChannelValue = 1900;
-uint16_t channelMidPoint = 1500;
+//RC input channel centre, microseconds, from the radio profile (src/RadioProfiles.h)  
+constexpr uint16_t channelMidPoint = activeRadio.channelMidPoint;
 
 //USB Joystick channel parameters 
-uint16_t minJoystickChannelValue = 0;
-uint16_t maxJoystickChannelValue = 1023;
+constexpr uint16_t minJoystickChannelValue = JOYSTICKREPORT_AXIS_MIN;
+constexpr uint16_t maxJoystickChannelValue = JOYSTICKREPORT_AXIS_MAX;
 
 //timestamp variables
 uint32_t timestampOld =0;
 uint32_t timestampNew =0;
+bool signalLossNew = false;  //the new frame is the failsafe frame of a signal loss 
 
 uint32_t timestampDataSentToUsb =0;
 uint32_t minDelayToSendToUsb = 1; //miliseconds  
 
+//startup times, microseconds since boot, 0 - not yet  
+uint32_t timeToEnumeration =0;
+uint32_t timeToFirstValidReport =0;
+
 
 //=================Set Up PPM receiver ======================
 //set a pin number for PPM input 
@@ -101,23 +173,300 @@ int channelAmountIn = 8;
 PPMReader ppm(channelAmountIn);
 
     //number of values to cover amount of channels, indexed {1..channelAmount}
-    uint16_t channelsIN[9];  // for PPM, 8 channels, 1..8, 9 values indexed {0..8}
-    //float channelsIN[9];  // for PPM, 8 channels, 1..8,9 values indexed {0..8}
+    uint16_t channelsIN[17];  // for PPM, up to 16 channels, 1..16, 17 values indexed {0..16}
+    //float channelsIN[17];  // for PPM, up to 16 channels, 1..16, 17 values indexed {0..16}
+
+     uint16_t channelsIN_MF[17];  // for Median Filter  - contains input channels after filter is applied 
+
+#ifdef ENABLE_FRACTIONAL_OUTPUT
+     uint16_t channelsIN_Q4[17];  // input channels after the filter, the trimmed mean in 1/16 us 
+#endif
+
+#ifndef ENABLE_TRAINER_INPUT
+//Frame queue of the PPM input, see readQueuedFrames() 
+     uint16_t channelsNext[17];  // the next queued frame 
+     uint32_t nextSequence = 0;  // sequence number of the next frame, a gap means frames were lost 
+#endif
+
+#ifdef ENABLE_TRAINER_INPUT
+//=================Set Up trainer PPM receiver ======================
+//set a pin number for the trainer PPM input 
+int PPMtrainerPin=3;
+//channel of the main input which gives control to the trainer input
+uint8_t trainerSwitchChannel=5;
 
-     uint16_t channelsIN_MF[9];  // for Median Filter  - contains input channels after filter is applied 
+PPMReader ppmTrainer(channelAmountIn);
+PPMMerger Merger;
+#endif
 	
+#ifdef ENABLE_PPM_OUTPUT
+//=================Set Up PPM output ======================
+//TIMER3 channel 1, pin 5 (PA6)
+PPMWriter PPMout(channelAmountIn);
+#endif
+
 //========Set Up Median Filter =====================
 MedianFilter Filter;
 
+//========Set Up Calibration =====================
+//Calibration mode is on while the button is held (the Maple Mini button, HIGH when pressed)
+const uint8_t calibrationButtonPin = BOARD_BUTTON_PIN;
+ChannelCalibration Calibration;
+
 	
 //=================Set Up Joystick ======================
+//Default mapping table, entries for channels above channelAmountIn are not used 
+//{source channel, type, target, flags, threshold (us, 0 - calibrated centre), hysteresis (us), switch positions}
+//Axes are 0..15: X, Y, Z, Rx, Ry, Rz, Slider, Dial, Wheel, Vx, Vy, Vz, Vbrx, Vbry, Vbrz, Vno; buttons are from 1  
+//e.g. a 3-position switch on Ch5 as buttons 3..5:  {5, MAPPING_SWITCH, 3, 0, 0, 10, 3}
+//     two 3-position switches on Ch9/Ch10 as a hat: {9, MAPPING_HAT_X, 0, 0, 0, 10, 0}, {10, MAPPING_HAT_Y, 0, 0, 0, 10, 0}
+const mappingEntry defaultMapping[] = {
+  { 1, MAPPING_AXIS,  0, 0, 0, 0, 0},
+  { 2, MAPPING_AXIS,  1, 0, 0, 0, 0},
+  { 3, MAPPING_AXIS,  2, 0, 0, 0, 0},
+  { 4, MAPPING_AXIS,  3, 0, 0, 0, 0},
+  { 5, MAPPING_AXIS,  4, 0, 0, 0, 0},
+  { 6, MAPPING_AXIS,  5, 0, 0, 0, 0},
+  { 7, MAPPING_AXIS,  6, 0, 0, 0, 0},
+  { 8, MAPPING_AXIS,  7, 0, 0, 0, 0},
+  { 9, MAPPING_AXIS,  8, 0, 0, 0, 0},
+  {10, MAPPING_AXIS,  9, 0, 0, 0, 0},
+  {11, MAPPING_AXIS, 10, 0, 0, 0, 0},
+  {12, MAPPING_AXIS, 11, 0, 0, 0, 0},
+  {13, MAPPING_AXIS, 12, 0, 0, 0, 0},
+  {14, MAPPING_AXIS, 13, 0, 0, 0, 0},
+  {15, MAPPING_AXIS, 14, 0, 0, 0, 0},
+  {16, MAPPING_AXIS, 15, 0, 0, 0, 0},
+  { 7, MAPPING_BUTTON, 1, 0, 0, 10, 0},
+  { 8, MAPPING_BUTTON, 2, 0, 0, 10, 0}
+};
+ChannelMapper Mapper;
 
 USBHID HID;
-HIDJoystick Joystick(HID);
+JoystickReport Report;
+HIDReporter Joystick(HID, Report.GetReport(), Report.GetReportSize(), Report.reportID);
+
+//=================Set Up signal statistics ======================
+//The statistics are read by the host as a feature report, see src/SignalStats.h for the layout.
+//Every statsReportInterval the report is updated with the next group of 4 channels.
+const uint8_t statsReportID = 2;
+const uint8_t statsReportSize = sizeof(signalStatsReport_t) - 1;  //without the report ID 
+uint32_t statsReportInterval = 100; //miliseconds
+uint32_t timestampStatsReported = 0;
+
+SignalStats Stats;
+uint8_t statsFeature[HID_BUFFER_ALLOCATE_SIZE(statsReportSize, 1)];
+
+//=================Set Up mapping upload ======================
+//The host writes a new mapping table with this feature report, see src/ChannelMapper.h for the layout 
+const uint8_t mappingReportID = 3;
+const uint8_t mappingReportSize = sizeof(mappingUploadReport_t) - 1;  //without the report ID 
+uint8_t mappingFeature[HID_BUFFER_ALLOCATE_SIZE(mappingReportSize, 1)];
+uint8_t mappingReport[sizeof(mappingUploadReport_t)];
+HIDReporter MappingReporter(HID, mappingReport, sizeof(mappingReport), mappingReportID);
+
+//=================Set Up memory monitor ======================
+//RAM and stack budget, read by the host as a feature report, see src/MemoryMonitor.h for the layout 
+const uint8_t memoryReportID = 4;
+const uint8_t memoryReportSize = sizeof(memoryReport_t) - 1;  //without the report ID 
+uint32_t memoryReportInterval = 1000; //miliseconds
+uint32_t timestampMemoryReported = 0;
+
+MemoryMonitor Memory;
+uint8_t memoryFeature[HID_BUFFER_ALLOCATE_SIZE(memoryReportSize, 1)];
+
+//=================Set Up diagnostics ======================
+//Startup times, signal loss and frame queue counters (PPMReader) and stage latencies (FrameScheduler), 
+//read by the host as a feature report (little endian, packed) 
+typedef struct {
+    uint8_t reportID;
+    uint16_t enumerationTime;    //time from boot to USB enumeration, ms, 0 - not yet 
+    uint16_t firstReportTime;    //time from boot to the first report with valid data, ms, 0 - not yet 
+    ppmDiagnostics reader;       //see src/PPMReader.h 
+    frameLatencies latencies;    //see src/FrameScheduler.h 
+} __attribute__((packed)) diagnosticsReport_t;
+
+const uint8_t diagnosticsReportID = 5;
+const uint8_t diagnosticsReportSize = sizeof(diagnosticsReport_t) - 1;  //without the report ID 
+uint32_t diagnosticsReportInterval = 100; //miliseconds
+uint32_t timestampDiagnosticsReported = 0;
+
+uint8_t diagnosticsFeature[HID_BUFFER_ALLOCATE_SIZE(diagnosticsReportSize, 1)];
+
+//=================Set Up frame scheduler ======================
+//Latency from the last edge of a frame to each stage, and the software interrupt of the deferred processing 
+FrameScheduler Scheduler;
+
+#ifdef ENABLE_DEFERRED_PROCESSING
+//The pipeline (decode, filter, PPM output, mapping) runs in the software interrupt, see processFrame(), 
+//with its own channels and report; loop() takes them with takeFrame() 
+uint16_t frameIN[17];
+uint16_t frameMF[17];
+JoystickReport PipelineReport;
+volatile uint32_t frameTimeStamp = 0;   //the last frame processed by the pipeline 
+volatile bool frameReady = false;       //processed and not taken by loop() yet 
+uint32_t frameTaken = 0;                //the last frame taken by loop() 
+#endif
+
+HIDBuffer_t featureBuffers[] = {
+  HIDBuffer_t(statsFeature, HID_BUFFER_SIZE(statsReportSize, 1), statsReportID, HID_BUFFER_MODE_NO_WAIT),
+  HIDBuffer_t(mappingFeature, HID_BUFFER_SIZE(mappingReportSize, 1), mappingReportID),
+  HIDBuffer_t(memoryFeature, HID_BUFFER_SIZE(memoryReportSize, 1), memoryReportID, HID_BUFFER_MODE_NO_WAIT),
+  HIDBuffer_t(diagnosticsFeature, HID_BUFFER_SIZE(diagnosticsReportSize, 1), diagnosticsReportID, HID_BUFFER_MODE_NO_WAIT)
+};
+
+
+#ifdef ENABLE_STACK_SAMPLES
+//=================Stack samples ===================================
+//Called first in the interrupts, the depth of each context is the stack pointer at its entry (a lower bound) 
+void sampleEdgeStack() {
+  MemoryMonitor::sampleStack(MEMORY_CONTEXT_PPM_ISR);
+}
+
+void sampleWatchdogStack() {
+  MemoryMonitor::sampleStack(MEMORY_CONTEXT_TIMER_ISR);
+}
+
+void sampleOutputStack() {
+  MemoryMonitor::sampleStack(MEMORY_CONTEXT_DMA_ISR);
+}
+#endif
+
+
+#ifndef ENABLE_TRAINER_INPUT
+//=================Frame queue ===================================
+//Takes all queued frames in one pass, oldest first: the older ones are filtered and added to the statistics here, 
+//the newest one is left in chIN for the caller. A gap of the sequence numbers (frames lost when the queue was full) 
+//restarts the filter. Returns the timestamp of the newest frame, 0 - no frame, signalLoss is set if the newest 
+//frame is the failsafe frame of a signal loss 
+uint32_t readQueuedFrames(uint16_t* chIN, uint16_t* chOUT, bool* signalLoss) {
+  uint32_t sequence = 0;
+  uint32_t timestamp = ppm.readFrame(chIN, &sequence, signalLoss);
+  while (timestamp != 0) {
+    if (sequence != nextSequence) {
+      Filter.Reset();
+    }
+    nextSequence = sequence + 1;
+
+    bool nextLoss = false;
+    uint32_t next = ppm.readFrame(channelsNext, &sequence, &nextLoss);
+    if (next == 0) {
+      break;
+    }
+    Filter.ApplyFilter(chIN, chOUT, timestamp);
+    Stats.update(chIN, timestamp);
+    memcpy(chIN, channelsNext, sizeof(channelsNext));
+    timestamp = next;
+    *signalLoss = nextLoss;
+  }
+  return timestamp;
+}
+#endif
+
+
+//=================Signal loss policy ===================================
+//The failsafe frame of a signal loss holds the last values, the policy (ppm.signalLossPolicy) is applied 
+//to the filtered frame here: the channels are set to their calibrated centre, or the throttle channel 
+//to its calibrated minimum, so the mapper outputs exactly the centre or the minimum of the axes. 
+//channelsQ4 (fractional output, NULL - none) is set to the same values in 1/16 us 
+void applySignalLossPolicy(uint16_t* channels, uint16_t* channelsQ4) {
+  uint8_t first = 1;
+  uint8_t last = 0;
+  switch (ppm.signalLossPolicy) {
+    case FAILSAFE_CENTER:
+      last = channelAmountIn;
+      for (uint8_t i = first; i <= last; ++i) {
+        channels[i] = Calibration.GetCentre(i);
+      }
+      break;
+    case FAILSAFE_THROTTLE_CUT:
+      if (ppm.throttleChannel >= 1 && ppm.throttleChannel <= channelAmountIn) {
+        first = ppm.throttleChannel;
+        last = ppm.throttleChannel;
+        channels[first] = Calibration.GetMin(first);
+      }
+      break;
+    case FAILSAFE_HOLD:
+      break;
+  }
+  if (channelsQ4 != NULL) {
+    for (uint8_t i = first; i <= last; ++i) {
+      channelsQ4[i] = channels[i] << 4;
+    }
+  }
+}
+
+
+#ifdef ENABLE_DEFERRED_PROCESSING
+//=================Deferred processing ===================================
+//The frame pipeline, runs in the software interrupt: decodes the queued edges, 
+//then a new frame is filtered, sent to the PPM output and mapped into PipelineReport. 
+//The signal statistics are updated here as well, loop() reads them between FrameScheduler::lock() and unlock(), 
+//the mapping table and the calibration are changed by loop() between them too 
+void processFrame() {
+  MemoryMonitor::sampleStack(MEMORY_CONTEXT_PIPELINE);
+  ppm.decodeEdges();
+#ifdef ENABLE_TRAINER_INPUT
+  ppmTrainer.decodeEdges();
+  uint32_t timestamp = Merger.readMerged(&frameIN[0]);
+  bool signalLoss = (frameIN[0] == ppm.codeFailSafe && ppm.IsSignalLost());
+#else
+  bool signalLoss = false;
+  uint32_t timestamp = readQueuedFrames(frameIN, frameMF, &signalLoss);
+#endif
+  if (timestamp == 0 || timestamp == frameTimeStamp) {
+    return;
+  }
+  frameTimeStamp = timestamp;
+  Scheduler.record(FRAME_STAGE_DECODED, timestamp, micros());
+
+#ifdef ENABLE_FRACTIONAL_OUTPUT
+  Filter.ApplyFilter(frameIN, frameMF, timestamp, channelsIN_Q4);
+#else
+  Filter.ApplyFilter(frameIN, frameMF, timestamp);
+#endif
+  if (signalLoss) {
+#ifdef ENABLE_FRACTIONAL_OUTPUT
+    applySignalLossPolicy(frameMF, channelsIN_Q4);
+#else
+    applySignalLossPolicy(frameMF, NULL);
+#endif
+  }
+#ifdef ENABLE_PPM_OUTPUT
+  PPMout.write(frameMF);
+#endif
+#ifdef ENABLE_FRACTIONAL_OUTPUT
+  Mapper.apply(frameMF, &PipelineReport, &Calibration, channelsIN_Q4);
+#else
+  Mapper.apply(frameMF, &PipelineReport, &Calibration);
+#endif
+  frameReady = true;
+  Scheduler.record(FRAME_STAGE_READY, timestamp, micros());
+  Stats.update(frameIN, timestamp);
+}
+
+//Takes the last frame of the pipeline into channelsIN, channelsIN_MF and Report. 
+//Returns its timestamp, the same one again if there is no new frame 
+uint32_t takeFrame() {
+  FrameScheduler::lock();
+  if (frameReady) {
+    frameReady = false;
+    frameTaken = frameTimeStamp;
+    memcpy(channelsIN, frameIN, sizeof(channelsIN));
+    memcpy(channelsIN_MF, frameMF, sizeof(channelsIN_MF));
+    memcpy(Report.GetReport(), PipelineReport.GetReport(), Report.GetReportSize());
+  }
+  FrameScheduler::unlock();
+  return frameTaken;
+}
+#endif
 
 
 //=================SETUP()===================================
 void setup() {
+
+  //paint the free stack first, for the stack high-water mark 
+  Memory.begin();
   
    // set the digital pin as output:
   pinMode(ledPin, OUTPUT);
@@ -140,60 +489,154 @@ Serial.println("Setup() started ");
 //=====setup Median Filter ===============
   Filter.channelAmountIn = channelAmountIn;
   Filter.channelAmountOut = channelAmountIn;  //use same number of channels for both input and output
+  //Filter window as a time budget - 5 points for a 22ms PPM frame, more points for faster frames 
+  Filter.maxWindowTime = 115000;  //microseconds
+  //The filter starts with the first valid frame, and again after a failsafe condition or a signal gap 
+  Filter.codeFailSafe = ppm.codeFailSafe;
+  Filter.reseedGap = 100000;  //microseconds
   Serial.println("Median Filter setup completed");
 
 
 
 
+//=====Set Up Calibration ===============
+//Without a saved calibration the endpoints and the centre are from the radio profile  
+  pinMode(calibrationButtonPin, INPUT);
+  Calibration.channelAmount = channelAmountIn;
+  Calibration.minOutputValue = minJoystickChannelValue;
+  Calibration.maxOutputValue = maxJoystickChannelValue;
+  Calibration.load();
+
+
 //begin the PPM communication
   //=======PPM setup=========
   //set the PPMinputPin as input,  pulled up for inverted polarity , pulled down for normal  
   pinMode(PPMinputPin, INPUT_PULLUP); 
   //attach interrupt  to the input pin.  The function is in the PPMReader class and it sets the interrupt pin and signal polarity  
+#ifdef ENABLE_DUAL_EDGE_CAPTURE
+  ppm.setupInterrupt(PPMinputPin, AUTO, true);
+#else
   ppm.setupInterrupt(PPMinputPin, INVERTED);
+#endif
+
+  //Signal loss watchdog: no edge for a frame period is a failsafe condition (Ch0 is codeFailSafe) 
+  //and the channels are set as per the policy: FAILSAFE_HOLD, FAILSAFE_CENTER or FAILSAFE_THROTTLE_CUT, 
+  //at their calibrated centre or minimum, see applySignalLossPolicy() 
+  ppm.signalLossFrames = 1;
+  ppm.signalLossPolicy = FAILSAFE_HOLD;
+  ppm.throttleChannel = 3;
+  ppm.setupSignalLossWatchdog();
+
+#ifndef ENABLE_TRAINER_INPUT
+  //Every complete frame is queued until it is taken, so a late loop() does not skip frames, see readQueuedFrames() 
+  ppm.setupFrameQueue();
+#endif
   
-  // correct the default values  
-  // The range of a channel's possible values, microseconds
-    ppm.minChannelValue = 700;
-    ppm.maxChannelValue = 2200;
-
- // The minimum value (time) after which the signal frame is considered to
- // be finished and we can start to expect a new signal frame.
-	//Minimal blank time for 8 channels is:
-	// PPM signal period - (150% max servo duration * 8 + 400us trailing pulse) 
-	// 22000 us - (2100*8 + 400) = 4800us  */   
-    ppm.blankTime = 5000;
-
-  //Calibration multipliers to apply to raw channel data values before 
-  //they are returned as a normalised data (rawValues[i] * multiplierScale + multiplierBias;)
-    //Walkera DEVO 12E values:
-    //to uS (1100..1900):
-	//  Scale=1.0f
-	//  Bias=-9.0f 
-	//to percentage (-100..+100):
-	//  Scale=0.250f
-	//  Bias=-377.250f 
-	//to float (-1..+1):
-	//  Scale=0.00250f
-	//  Bias=-3.77250f
-    ppm.multiplierScale = 1.0f;
-    ppm.multiplierBias = 0.0f;
+  // The range of a channel's possible values, blank time, calibration multipliers 
+  // and failsafe detection are taken from the radio profile, see src/RadioProfiles.h 
 //====================================
 
+#ifdef ENABLE_TRAINER_INPUT
+  //=======Trainer PPM setup=========
+  pinMode(PPMtrainerPin, INPUT_PULLUP); 
+  ppmTrainer.setupInterrupt(PPMtrainerPin, INVERTED);
+
+  //main input is the instructor (input 0), trainer input is the student (input 1) 
+  Merger.channelAmount = channelAmountIn;
+  Merger.addInput(&ppm);
+  Merger.addInput(&ppmTrainer);
+  for (uint8_t i = 1; i <= channelAmountIn; ++i) {
+    Merger.setChannelRule(i, 0, 1);
+  }
+  //the trainer switch itself always stays with the instructor
+  Merger.setChannelRule(trainerSwitchChannel, 0, 0);
+  Merger.overrideSwitchInput = 0;
+  Merger.overrideSwitchChannel = trainerSwitchChannel;
+  Merger.overrideSwitchThreshold = channelMidPoint;
+#endif
+
+
+#ifdef ENABLE_PPM_OUTPUT
+//=====Set Up PPM output ===============
+  PPMout.polarity = INVERTED;
+  PPMout.begin();
+#endif
+
+//=====Set Up signal statistics ===============
+  Stats.channelAmount = channelAmountIn;
+  Report.addFeatureReport(statsReportID, statsReportSize);
+
+//=====Set Up Mapping ===============
+  Mapper.channelAmount = channelAmountIn;
+  Mapper.setTable(defaultMapping, sizeof(defaultMapping) / sizeof(defaultMapping[0]));
+  Report.addFeatureReport(mappingReportID, mappingReportSize);
+
+//=====Set Up Memory monitor ===============
+//RAM of the objects and buffers of each module, the flash and the libraries are in the linker map 
+  Memory.setModuleSize(MEMORY_MODULE_PPMREADER, sizeof(ppm) + (channelAmountIn + 1) * sizeof(uint16_t));
+  Memory.setModuleSize(MEMORY_MODULE_MEDIANFILTER, sizeof(Filter));
+  Memory.setModuleSize(MEMORY_MODULE_CALIBRATION, sizeof(Calibration));
+  Memory.setModuleSize(MEMORY_MODULE_MAPPER, sizeof(Mapper));
+  Memory.setModuleSize(MEMORY_MODULE_STATS, sizeof(Stats) + sizeof(statsFeature));
+  Memory.setModuleSize(MEMORY_MODULE_JOYSTICKREPORT, sizeof(Report));
+#ifdef ENABLE_DEFERRED_PROCESSING
+  Memory.setModuleSize(MEMORY_MODULE_JOYSTICKREPORT, sizeof(Report) + sizeof(PipelineReport));
+#endif
+#ifdef ENABLE_PPM_OUTPUT
+  Memory.setModuleSize(MEMORY_MODULE_PPMWRITER, sizeof(PPMout));
+#endif
+#ifdef ENABLE_TRAINER_INPUT
+  Memory.setModuleSize(MEMORY_MODULE_PPMREADER, 2 * (sizeof(ppm) + (channelAmountIn + 1) * sizeof(uint16_t)));
+  Memory.setModuleSize(MEMORY_MODULE_PPMMERGER, sizeof(Merger));
+#endif
+  Memory.setModuleSize(MEMORY_MODULE_USB, sizeof(HID) + sizeof(Joystick) + sizeof(MappingReporter) + sizeof(featureBuffers)
+                                          + sizeof(mappingFeature) + sizeof(mappingReport) + sizeof(memoryFeature)
+                                          + sizeof(diagnosticsFeature));
+  uint16_t sketchSize = sizeof(channelsIN) + sizeof(channelsIN_MF) + sizeof(Memory) + sizeof(Scheduler);
+#ifdef ENABLE_FRACTIONAL_OUTPUT
+  sketchSize += sizeof(channelsIN_Q4);
+#endif
+#ifdef ENABLE_DEFERRED_PROCESSING
+  sketchSize += sizeof(frameIN) + sizeof(frameMF);
+#endif
+#ifndef ENABLE_TRAINER_INPUT
+  sketchSize += sizeof(channelsNext);
+#endif
+  Memory.setModuleSize(MEMORY_MODULE_SKETCH, sketchSize);
+  Report.addFeatureReport(memoryReportID, memoryReportSize);
+
+//=====Set Up diagnostics ===============
+  Report.addFeatureReport(diagnosticsReportID, diagnosticsReportSize);
+
+#ifdef ENABLE_STACK_SAMPLES
+  ppm.edgeHook = sampleEdgeStack;
+  ppm.watchdogHook = sampleWatchdogStack;
+#ifdef ENABLE_TRAINER_INPUT
+  ppmTrainer.edgeHook = sampleEdgeStack;
+  ppmTrainer.watchdogHook = sampleWatchdogStack;
+#endif
+#ifdef ENABLE_PPM_OUTPUT
+  PPMout.interruptHook = sampleOutputStack;
+#endif
+#endif
 
 //=====Set Up Joystick ===============
-HID.begin(HID_JOYSTICK);
-
-/* joystick reference:
-X
-Y
-Xrotate
-Yrotate
-sliderLeft
-sliderRight
-hat(direction in dergees)
-button(number,value) 
-*/
+//Poll the joystick every 1ms 
+HID.setTXInterval(JOYSTICKREPORT_POLL_INTERVAL_MS);
+HID.begin(Report.GetDescriptor(), Report.GetDescriptorSize());
+HID.setFeatureBuffers(featureBuffers, sizeof(featureBuffers) / sizeof(featureBuffers[0]));
+
+#ifdef ENABLE_DEFERRED_PROCESSING
+//=====Set Up deferred processing ===============
+//The edge interrupts only queue the edge times and request the software interrupt, they are above it 
+  ppm.setupDeferredDecode(FrameScheduler::trigger);
+  ppm.setInterruptPriority(FRAMESCHEDULER_PRIORITY_EDGE);
+#ifdef ENABLE_TRAINER_INPUT
+  ppmTrainer.setupDeferredDecode(FrameScheduler::trigger);
+  ppmTrainer.setInterruptPriority(FRAMESCHEDULER_PRIORITY_EDGE);
+#endif
+  Scheduler.begin(processFrame);
+#endif
 
 }
 //=====END OF SETUP ()=================================================
@@ -201,13 +644,24 @@ button(number,value)
 
 //==================LOOP()==============================================
 void loop() {
+MemoryMonitor::sampleStack(MEMORY_CONTEXT_LOOP);
 
 //acquire the data into a local array
-timestampNew = ppm.readNormalisedInteger(&channelsIN[0]);
+#if defined(ENABLE_DEFERRED_PROCESSING)
+timestampNew = takeFrame();  //already filtered and mapped into Report by the software interrupt
+#elif defined(ENABLE_TRAINER_INPUT)
+timestampNew = Merger.readMerged(&channelsIN[0]);
+signalLossNew = (channelsIN[0] == ppm.codeFailSafe && ppm.IsSignalLost());
+#else
+timestampNew = readQueuedFrames(&channelsIN[0], &channelsIN_MF[0], &signalLossNew);  //the frames before the newest are filtered here
+#endif
 
 if(timestampNew!=0 && timestampNew!=timestampOld){ //data is ready and it is a new data 
   //update timestamp
     timestampOld = timestampNew;
+#ifndef ENABLE_DEFERRED_PROCESSING
+    Scheduler.record(FRAME_STAGE_DECODED, timestampNew, micros());
+#endif
 
     
    //optional - blinking /serial debug
@@ -232,28 +686,69 @@ if(timestampNew!=0 && timestampNew!=timestampOld){ //data is ready and it is a n
   #endif
   //==========================================================================
 
+#ifndef ENABLE_DEFERRED_PROCESSING
   //Apply Median Filter   
-    Filter.ApplyFilter(channelsIN, channelsIN_MF);
+#ifdef ENABLE_FRACTIONAL_OUTPUT
+    Filter.ApplyFilter(channelsIN, channelsIN_MF, timestampNew, channelsIN_Q4);
+#else
+    Filter.ApplyFilter(channelsIN, channelsIN_MF, timestampNew);
+#endif
     //Filter.Passthrough(channelsIN, channelsIN_MF);
+    if (signalLossNew) {
+#ifdef ENABLE_FRACTIONAL_OUTPUT
+      applySignalLossPolicy(channelsIN_MF, channelsIN_Q4);
+#else
+      applySignalLossPolicy(channelsIN_MF, NULL);
+#endif
+    }
+
+#ifdef ENABLE_PPM_OUTPUT
+  //Pass the filtered frame to the PPM output, it is sent from the next frame period  
+    PPMout.write(channelsIN_MF);
+#endif
+#endif
+
+  //Calibration mode while the button is held, new mapping coefficients are used from this frame. 
+  //The software interrupt maps the frames with them in the deferred processing, so it waits for the update 
+  //(and for the flash write at the end, the edges are queued meanwhile) 
+    if (digitalRead(calibrationButtonPin) == HIGH) {
+      FrameScheduler::lock();
+      if (!Calibration.isCalibrating()) {
+        Calibration.begin();
+      }
+      Calibration.update(channelsIN_MF);
+      FrameScheduler::unlock();
+    }
+    else if (Calibration.isCalibrating()) {
+      FrameScheduler::lock();
+      Calibration.end();  //saves the calibration
+      FrameScheduler::unlock();
+    }
   
     
   // Convert PPM values to USB joystick values and send them to USB 
   if (millis()- timestampDataSentToUsb >= minDelayToSendToUsb) { //delay if needed
     timestampDataSentToUsb  = millis(); 
   
-   Joystick.X(PpmToJoystickValue(channelsIN_MF[1]));            //      (1)Aileron 
-   Joystick.Y(PpmToJoystickValue(channelsIN_MF[2]));            //      (2)Eelev
-   Joystick.Xrotate(PpmToJoystickValue(channelsIN_MF[4]));      //      (4)Rudder
-   Joystick.Yrotate(PpmToJoystickValue(channelsIN_MF[5]));      //      (5)Gear
-   Joystick.sliderLeft(PpmToJoystickValue(channelsIN_MF[6]));   //      (6)Ch6 (flaps)
-   Joystick.sliderRight(PpmToJoystickValue(channelsIN_MF[3]));  //      (3)Throttle  
-   Joystick.button(1,(channelsIN_MF[7] > channelMidPoint));      //     (7)Ch7
-   Joystick.button(2,(channelsIN_MF[8] > channelMidPoint));      //     (8)Ch8 
-   //Joystick.hat(0);
-   
-   Joystick.send();
+#ifndef ENABLE_DEFERRED_PROCESSING
+#ifdef ENABLE_FRACTIONAL_OUTPUT
+   Mapper.apply(channelsIN_MF, &Report, &Calibration, channelsIN_Q4);
+#else
+   Mapper.apply(channelsIN_MF, &Report, &Calibration);
+#endif
+   Scheduler.record(FRAME_STAGE_READY, timestampNew, micros());
+#endif
+   Joystick.sendReport();
+   Scheduler.record(FRAME_STAGE_SENT, timestampNew, micros());
+   if (timeToFirstValidReport == 0 && channelsIN[0] != ppm.codeFailSafe) {
+     timeToFirstValidReport = micros();
+   }
   }
 
+#ifndef ENABLE_DEFERRED_PROCESSING
+  //Update the signal statistics after the report is sent, so it is not delayed  
+    Stats.update(channelsIN, timestampNew);
+#endif
 
 
 } 
@@ -269,37 +764,72 @@ else
    
         }
 
-        
        //optional - blinking /serial debug     
        gpio_write_bit(GPIOB,1,LOW);
       
    }
 
+  //Housekeeping, after the report of a new frame has been sent. It is not only done while there is no new frame, 
+  //a late loop() has a new frame from the frame queue every time
+  //Boot to USB enumeration time 
+  if (timeToEnumeration == 0 && USBComposite.isReady()) {
+    timeToEnumeration = micros();
+  }
 
+  //Update the signal statistics feature report
+  if (millis() - timestampStatsReported >= statsReportInterval) {
+    timestampStatsReported = millis();
+    uint8_t statsReport[sizeof(signalStatsReport_t)];
+    Stats.setReaderCounters(ppm.GetFrameCount(), ppm.GetRejectedPulseCount());
+    FrameScheduler::lock();  //the software interrupt updates the statistics with the deferred processing 
+    Stats.writeFeatureReport(statsReport, statsReportID);
+    FrameScheduler::unlock();
+    //the USB interrupt reads the buffer when the host asks for the report  
+    noInterrupts();
+    memcpy(statsFeature, statsReport, sizeof(statsReport));
+    interrupts();
+  }
 
 
- 
-}
-//============ END OF LOOP() =============================================
-
-
+  //Update the diagnostics feature report, the times are rounded up to ms so a time below 1 ms is not 0 (not yet) 
+  if (millis() - timestampDiagnosticsReported >= diagnosticsReportInterval) {
+    timestampDiagnosticsReported = millis();
+    diagnosticsReport_t diagnostics;
+    diagnostics.reportID = diagnosticsReportID;
+    uint32_t enumerationTime = (timeToEnumeration + 999) / 1000;
+    uint32_t firstReportTime = (timeToFirstValidReport + 999) / 1000;
+    diagnostics.enumerationTime = (enumerationTime < 0xFFFF) ? enumerationTime : 0xFFFF;
+    diagnostics.firstReportTime = (firstReportTime < 0xFFFF) ? firstReportTime : 0xFFFF;
+    ppm.writeDiagnostics(&diagnostics.reader);
+    Scheduler.writeLatencies(&diagnostics.latencies);
+    noInterrupts();
+    memcpy(diagnosticsFeature, &diagnostics, sizeof(diagnostics));
+    interrupts();
+  }
 
 
+  //Update the memory monitor feature report, the painted stack is scanned  
+  if (millis() - timestampMemoryReported >= memoryReportInterval) {
+    timestampMemoryReported = millis();
+    uint8_t memoryReport[sizeof(memoryReport_t)];
+    Memory.writeFeatureReport(memoryReport, memoryReportID);
+    noInterrupts();
+    memcpy(memoryFeature, memoryReport, sizeof(memoryReport));
+    interrupts();
+  }
 
 
+  //A new mapping table from the host, it is used from the next frame 
+  //(not while the software interrupt maps a frame with the deferred processing) 
+  uint16_t mappingReportLength = MappingReporter.getFeature(mappingReport);
+  if (mappingReportLength > 0) {
+    FrameScheduler::lock();
+    Mapper.receive(mappingReport, mappingReportLength);
+    FrameScheduler::unlock();
+  }
 
-//=========== Helper Functions =========================================== 
+}
 
-//This function converts an input value 
-//in the range of [minNormalChannelValue - maxNormalChannelValue] 
-//to the range of [minJoystickChannelValue - maxJoystickChannelValue] 
-//  reference: map(value, fromLow, fromHigh, toLow, toHigh)
-uint16_t PpmToJoystickValue(uint16_t ppmValue) { 
-  return constrain( 
-                    map(ppmValue, minNormalChannelValue, maxNormalChannelValue, minJoystickChannelValue, maxJoystickChannelValue), 
-                    minJoystickChannelValue, 
-                    maxJoystickChannelValue 
-                  ); 
- } 
+//============ END OF LOOP() =============================================
 
 
@@ -0,0 +1,139 @@
+/*
+Host stubs of the Arduino for STM32 core for the virtual-time simulator.
+
+=================================================================
+(C) 2026 ifh
+This file is part of PPM to USB Joystick.
+
+PPM to USB Joystick is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+PPM to USB Joystick is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+*/
+
+#include "Arduino.h"
+
+#define SIM_PIN_AMOUNT 64
+
+SimSerial Serial;
+
+static gpio_dev gpioA = { 0 };
+static gpio_dev gpioB = { 1 };
+gpio_dev* const GPIOA = &gpioA;
+gpio_dev* const GPIOB = &gpioB;
+
+//Simulated time, microseconds
+static uint32_t simTime = 0;
+
+//noInterrupts() calls, see Arduino.h
+uint32_t simNoInterruptsCalls = 0;
+
+//Simulated pins and attached interrupts
+static uint8_t pinLevels[SIM_PIN_AMOUNT];
+static voidArgumentFuncPtr pinHandlers[SIM_PIN_AMOUNT];
+static void* pinHandlerArgs[SIM_PIN_AMOUNT];
+static voidFuncPtr pinPlainHandlers[SIM_PIN_AMOUNT];
+static ExtIntTriggerMode pinModes[SIM_PIN_AMOUNT];
+
+
+uint32_t micros() {
+	return simTime;
+}
+
+uint32_t millis() {
+	return simTime / 1000;
+}
+
+void delay(uint32_t ms) {
+	simTime += ms * 1000;
+}
+
+void delayMicroseconds(uint32_t us) {
+	simTime += us;
+}
+
+
+void attachInterrupt(uint8_t pin, voidArgumentFuncPtr handler, void* arg, ExtIntTriggerMode mode) {
+	if (pin < SIM_PIN_AMOUNT) {
+		pinHandlers[pin] = handler;
+		pinHandlerArgs[pin] = arg;
+		pinPlainHandlers[pin] = NULL;
+		pinModes[pin] = mode;
+	}
+}
+
+void attachInterrupt(uint8_t pin, voidFuncPtr handler, ExtIntTriggerMode mode) {
+	if (pin < SIM_PIN_AMOUNT) {
+		pinHandlers[pin] = NULL;
+		pinPlainHandlers[pin] = handler;
+		pinModes[pin] = mode;
+	}
+}
+
+void detachInterrupt(uint8_t pin) {
+	if (pin < SIM_PIN_AMOUNT) {
+		pinHandlers[pin] = NULL;
+		pinPlainHandlers[pin] = NULL;
+	}
+}
+
+
+void pinMode(uint8_t pin, WiringPinMode mode) {
+	//pulled up inputs are idle HIGH
+	if (pin < SIM_PIN_AMOUNT && mode == INPUT_PULLUP) {
+		pinLevels[pin] = HIGH;
+	}
+}
+
+uint32_t digitalRead(uint8_t pin) {
+	return (pin < SIM_PIN_AMOUNT) ? pinLevels[pin] : LOW;
+}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+	if (pin < SIM_PIN_AMOUNT) {
+		pinLevels[pin] = value ? HIGH : LOW;
+	}
+}
+
+void gpio_write_bit(gpio_dev* dev, uint8_t bit, uint8_t value) {
+	(void)dev; (void)bit; (void)value;
+}
+
+
+long map(long value, long fromStart, long fromEnd, long toStart, long toEnd) {
+	return (value - fromStart) * (toEnd - toStart) / (fromEnd - fromStart) + toStart;
+}
+
+
+void simSetTime(uint32_t us) {
+	simTime = us;
+}
+
+void simSetPinLevel(uint8_t pin, uint8_t level) {
+	if (pin >= SIM_PIN_AMOUNT || pinLevels[pin] == level) {
+		return;
+	}
+	pinLevels[pin] = level;
+
+	bool fire = (pinModes[pin] == CHANGE)
+	            || (pinModes[pin] == RISING && level == HIGH)
+	            || (pinModes[pin] == FALLING && level == LOW);
+	if (!fire) {
+		return;
+	}
+	if (pinHandlers[pin] != NULL) {
+		pinHandlers[pin](pinHandlerArgs[pin]);
+	}
+	else if (pinPlainHandlers[pin] != NULL) {
+		pinPlainHandlers[pin]();
+	}
+}
@@ -0,0 +1,101 @@
+/*
+Host stubs of the Arduino for STM32 core for the virtual-time simulator.
+
+Only the functions used by the sketch and the libraries in src/ are provided.
+micros()/millis() return the simulated time, attachInterrupt() handlers are called
+by the simulator when a simulated pin level changes.
+
+=================================================================
+(C) 2026 ifh
+This file is part of PPM to USB Joystick.
+
+PPM to USB Joystick is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+PPM to USB Joystick is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+*/
+
+#ifndef SIMULATOR_ARDUINO_H
+#define SIMULATOR_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define HIGH 1
+#define LOW 0
+#define LED_BUILTIN 33
+#define BOARD_BUTTON_PIN 32
+
+typedef enum WiringPinMode {
+    OUTPUT, OUTPUT_OPEN_DRAIN, INPUT, INPUT_ANALOG, INPUT_PULLUP, INPUT_PULLDOWN, INPUT_FLOATING, PWM, PWM_OPEN_DRAIN
+} WiringPinMode;
+
+typedef enum ExtIntTriggerMode {
+    RISING, FALLING, CHANGE
+} ExtIntTriggerMode;
+
+typedef void (*voidFuncPtr)(void);
+typedef void (*voidArgumentFuncPtr)(void*);
+
+//Time
+uint32_t micros();
+uint32_t millis();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+
+//Interrupts, the simulator runs interrupts between loop() calls so there is nothing to disable.
+//The noInterrupts() calls are only counted, a measure of the code which disables the interrupts
+void attachInterrupt(uint8_t pin, voidArgumentFuncPtr handler, void* arg, ExtIntTriggerMode mode);
+void attachInterrupt(uint8_t pin, voidFuncPtr handler, ExtIntTriggerMode mode);
+void detachInterrupt(uint8_t pin);
+extern uint32_t simNoInterruptsCalls;
+static inline void noInterrupts() { ++simNoInterruptsCalls; }
+static inline void interrupts() {}
+
+//Pins
+void pinMode(uint8_t pin, WiringPinMode mode);
+uint32_t digitalRead(uint8_t pin);
+void digitalWrite(uint8_t pin, uint8_t value);
+
+typedef struct gpio_dev { uint8_t port; } gpio_dev;
+extern gpio_dev* const GPIOA;
+extern gpio_dev* const GPIOB;
+void gpio_write_bit(gpio_dev* dev, uint8_t bit, uint8_t value);
+
+//Math
+#define constrain(amt,low,high) ((amt)<(low)?(low):((amt)>(high)?(high):(amt)))
+long map(long value, long fromStart, long fromEnd, long toStart, long toEnd);
+
+//Serial output is discarded
+class SimSerial {
+  public:
+    void begin(uint32_t) {}
+    template <typename T> void print(T) {}
+    template <typename T> void print(T, int) {}
+    template <typename T> void println(T) {}
+    void println() {}
+    operator bool() { return true; }
+};
+extern SimSerial Serial;
+
+
+//=================Simulator hooks ======================
+//Set the simulated time, microseconds
+void simSetTime(uint32_t us);
+
+//Set a simulated pin level, calls the attached interrupt handler if the level change matches its mode
+void simSetPinLevel(uint8_t pin, uint8_t level);
+
+#endif
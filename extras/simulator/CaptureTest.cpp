@@ -0,0 +1,112 @@
+/*
+Capture replay test of the virtual-time simulator.
+
+The same generated edges drive two PPMReaders, a single-edge one and a dual-edge one (AUTO polarity),
+each decoded frame is compared with the generated one. Run it with noise, e.g.
+  ppm_simulator --scenario=capture --jitter=10 --spike-frames=5
+
+=================================================================
+(C) 2026 ifh
+This file is part of PPM to USB Joystick.
+
+PPM to USB Joystick is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+PPM to USB Joystick is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+*/
+
+#include <stdio.h>
+#include <math.h>
+#include <algorithm>
+
+#include "Arduino.h"
+#include "PPMReader.h"
+#include "SimTest.h"
+
+#define CAPTURE_SINGLE_PIN 41
+#define CAPTURE_DUAL_PIN 42
+
+typedef struct captureResult {
+    uint32_t frames = 0;
+    uint32_t samples = 0;
+    double sumSquares = 0;
+    uint32_t maxError = 0;
+    uint32_t lastTimeStamp = 0;
+} captureResult;
+
+//Compares a new frame of a reader with the generated frame
+static void captureCompare(PPMReader& reader, const generatedFrame& frame, uint8_t channels, captureResult& result) {
+	if (!reader.IsDataReady() || reader.GetDataInputTimeStamp() == result.lastTimeStamp) {
+		return;
+	}
+	uint16_t decoded[PPMGENERATOR_MAX_CHANNELS + 1];
+	result.lastTimeStamp = reader.readRaw(decoded);
+	++result.frames;
+	for (uint8_t i = 1; i <= channels; i++) {
+		uint32_t error = abs((int32_t)decoded[i] - (int32_t)frame.values[i]);
+		result.sumSquares += (double)error * error;
+		result.maxError = std::max(result.maxError, error);
+		++result.samples;
+	}
+}
+
+static double captureRms(const captureResult& result) {
+	return result.samples > 0 ? sqrt(result.sumSquares / result.samples) : 0.0;
+}
+
+static void printCapture(const char* name, const captureResult& result) {
+	printf("%s: %u frames, channel error rms=%.2fus max=%uus\n", name, result.frames, captureRms(result), result.maxError);
+}
+
+
+void captureTest(const generatorConfig& config, uint32_t duration) {
+	PPMGenerator generator(config);
+	PPMReader single(config.channelAmount);
+	PPMReader dual(config.channelAmount);
+	captureResult singleResult;
+	captureResult dualResult;
+
+	simSetPinLevel(CAPTURE_SINGLE_PIN, generator.GetIdleLevel());
+	simSetPinLevel(CAPTURE_DUAL_PIN, generator.GetIdleLevel());
+	single.setupInterrupt(CAPTURE_SINGLE_PIN, config.inverted ? INVERTED : NORMAL);
+	dual.setupInterrupt(CAPTURE_DUAL_PIN, AUTO, true);
+
+	while (generator.peekEdge().time < duration) {
+		ppmEdge edge = generator.peekEdge();
+		generator.popEdge();
+		simSetTime(edge.time);
+		simSetPinLevel(CAPTURE_SINGLE_PIN, edge.level);
+		simSetPinLevel(CAPTURE_DUAL_PIN, edge.level);
+		//the frame of this edge is the last one generated
+		const generatedFrame& frame = generator.frames.back();
+		if (!frame.failsafe) {
+			captureCompare(single, frame, config.channelAmount, singleResult);
+			captureCompare(dual, frame, config.channelAmount, dualResult);
+		}
+	}
+
+	printCapture("Single-edge capture", singleResult);
+	printCapture("Dual-edge capture", dualResult);
+	printf("Dual-edge polarity: %s, rejected separators: %u\n",
+	       dual.GetPolarity() == AUTO ? "not detected" : (dual.GetPolarity() == INVERTED ? "inverted" : "normal"),
+	       dual.GetRejectedPulseCount());
+
+	//the polarity is detected within the first frames, after it every frame is read
+	uint32_t frames = generator.frames.size();
+	simCheck(dual.GetPolarity() == (config.inverted ? INVERTED : NORMAL), "dual-edge polarity detected");
+	simCheck(dualResult.frames + 8 >= frames, "dual-edge frames %u of %u generated", dualResult.frames, frames);
+	simCheck(dualResult.maxError <= 2u * config.jitter + 1, "dual-edge max error %uus <= 2 x jitter", dualResult.maxError);
+	simCheck(captureRms(dualResult) <= captureRms(singleResult), "dual-edge rms error <= single-edge rms error");
+	if (config.spikeFrames != 0) {
+		simCheck(dual.GetRejectedPulseCount() >= frames / config.spikeFrames - 1, "dual-edge rejects the noise spikes");
+	}
+}
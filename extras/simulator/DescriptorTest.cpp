@@ -0,0 +1,274 @@
+/*
+Report descriptor test of the virtual-time simulator.
+
+The report descriptor of JoystickReport, with the feature reports of the sketch, is parsed item by item
+as a host would (no sketch):
+ - the size of every report ID, the input report against GetReportSize(), the feature reports against the
+   sizes they were added with
+ - the usages, logical range and size of the axes, the buttons and the hats
+ - the bit offset of every axis, button and hat in the parsed input report against the byte that
+   setAxis(), setButton() and setHat() write in GetReport()
+ - the collections are balanced and the feature reports are in a vendor defined application collection
+e.g. ppm_simulator --scenario=descriptor
+
+=================================================================
+(C) 2026 ifh
+This file is part of PPM to USB Joystick.
+
+PPM to USB Joystick is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+PPM to USB Joystick is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+*/
+
+#include <stdio.h>
+#include <vector>
+
+#include "Arduino.h"
+#include "JoystickReport.h"
+#include "SignalStats.h"
+#include "ChannelMapper.h"
+#include "MemoryMonitor.h"
+#include "PPMReader.h"
+#include "FrameScheduler.h"
+#include "SimTest.h"
+
+#define DESCRIPTOR_MAX_REPORT_IDS 256
+
+//A variable field of an input report, as the host sees it
+typedef struct descriptorField {
+    uint8_t reportID;
+    uint16_t usagePage;
+    uint16_t usage;
+    int32_t logicalMinimum;
+    int32_t logicalMaximum;
+    uint8_t size;      //bits
+    uint32_t offset;   //bits from the first byte after the report ID
+} descriptorField;
+
+typedef struct descriptorResult {
+    std::vector<descriptorField> inputs;
+    uint32_t inputBits[DESCRIPTOR_MAX_REPORT_IDS] = {};
+    uint32_t featureBits[DESCRIPTOR_MAX_REPORT_IDS] = {};
+    uint32_t featuresOutsideVendor = 0;  //feature items not in a vendor defined application collection
+    uint32_t inputsInVendor = 0;         //input items in a vendor defined application collection
+    int32_t openCollections = 0;
+    bool malformed = false;
+} descriptorResult;
+
+//Returns the data of an item, signed for the logical minimum and maximum
+static int32_t descriptorValue(const uint8_t* data, uint8_t size, bool isSigned) {
+	uint32_t value = 0;
+	for (uint8_t i = 0; i < size; i++) {
+		value |= (uint32_t)data[i] << (8 * i);
+	}
+	if (isSigned && size > 0 && size < 4 && (value & (1u << (8 * size - 1))) != 0) {
+		value |= ~0u << (8 * size);
+	}
+	return (int32_t)value;
+}
+
+//Parses the short items of a report descriptor
+static void parseDescriptor(const uint8_t* descriptor, uint16_t size, descriptorResult& result) {
+	//global items
+	uint16_t usagePage = 0;
+	int32_t logicalMinimum = 0;
+	int32_t logicalMaximum = 0;
+	uint8_t reportSize = 0;
+	uint8_t reportCount = 0;
+	uint8_t reportID = 0;
+	//local items
+	std::vector<uint16_t> usages;
+	uint16_t usageMinimum = 0;
+	uint16_t usageMaximum = 0;
+	bool usageRange = false;
+	//usage page of each open application collection
+	std::vector<uint16_t> collectionPages;
+
+	uint16_t k = 0;
+	while (k < size) {
+		uint8_t prefix = descriptor[k];
+		uint8_t dataSize = (prefix & 3) == 3 ? 4 : (prefix & 3);
+		if (prefix == 0xFE || k + 1 + dataSize > size) {
+			result.malformed = true;  //long items are not used
+			return;
+		}
+		const uint8_t* data = &descriptor[k + 1];
+		uint32_t value = (uint32_t)descriptorValue(data, dataSize, false);
+		k += 1 + dataSize;
+
+		switch (prefix & 0xFC) {
+		//main items
+		case 0x80:  //Input
+		case 0xB0: {  //Feature
+			bool inVendor = false;
+			for (size_t c = 0; c < collectionPages.size(); c++) {
+				inVendor = inVendor || collectionPages[c] >= 0xFF00;
+			}
+			uint32_t bits = (uint32_t)reportSize * reportCount;
+			if ((prefix & 0xFC) == 0xB0) {
+				result.featureBits[reportID] += bits;
+				result.featuresOutsideVendor += inVendor ? 0 : 1;
+			}
+			else {
+				result.inputsInVendor += inVendor ? 1 : 0;
+				if ((value & 0x01) == 0) {  //data, not constant
+					for (uint8_t j = 0; j < reportCount; j++) {
+						descriptorField field;
+						field.reportID = reportID;
+						field.usagePage = usagePage;
+						if (usageRange) {
+							field.usage = usageMinimum + j;
+						}
+						else {
+							field.usage = usages.empty() ? 0 : usages[j < usages.size() ? j : usages.size() - 1];
+						}
+						field.logicalMinimum = logicalMinimum;
+						field.logicalMaximum = logicalMaximum;
+						field.size = reportSize;
+						field.offset = result.inputBits[reportID] + (uint32_t)j * reportSize;
+						result.inputs.push_back(field);
+					}
+				}
+				result.inputBits[reportID] += bits;
+			}
+			usages.clear();
+			usageRange = false;
+			break;
+		}
+		case 0xA0:  //Collection
+			collectionPages.push_back(value == 0x01 ? usagePage : 0);
+			++result.openCollections;
+			usages.clear();
+			usageRange = false;
+			break;
+		case 0xC0:  //End Collection
+			if (collectionPages.empty()) {
+				result.malformed = true;
+				return;
+			}
+			collectionPages.pop_back();
+			--result.openCollections;
+			break;
+		//global items
+		case 0x04: usagePage = value; break;
+		case 0x14: logicalMinimum = descriptorValue(data, dataSize, true); break;
+		case 0x24: logicalMaximum = descriptorValue(data, dataSize, true); break;
+		case 0x74: reportSize = value; break;
+		case 0x84: reportID = value; break;
+		case 0x94: reportCount = value; break;
+		//local items
+		case 0x08: usages.push_back(value); break;
+		case 0x18: usageMinimum = value; usageRange = true; break;
+		case 0x28: usageMaximum = value; usageRange = true; break;
+		default: break;
+		}
+	}
+	(void)usageMaximum;
+}
+
+//Returns the field of a usage in the input report or NULL
+static const descriptorField* findField(const descriptorResult& result, uint16_t usagePage, uint16_t usage, uint8_t index = 0) {
+	for (size_t i = 0; i < result.inputs.size(); i++) {
+		if (result.inputs[i].usagePage == usagePage && result.inputs[i].usage == usage && index-- == 0) {
+			return &result.inputs[i];
+		}
+	}
+	return NULL;
+}
+
+//Reads a field from a report buffer (after the report ID)
+static uint32_t readField(const uint8_t* report, const descriptorField& field) {
+	uint32_t value = 0;
+	for (uint8_t b = 0; b < field.size; b++) {
+		uint32_t bit = field.offset + b;
+		value |= (uint32_t)((report[1 + bit / 8] >> (bit % 8)) & 1) << b;
+	}
+	return value;
+}
+
+
+void descriptorTest(const generatorConfig& config, uint32_t duration) {
+	static const uint8_t axisUsages[16] = { 0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37,
+	                                        0x38, 0x40, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46 };
+	//the feature reports of the sketch, the diagnostics report is two startup times and the PPMReader and
+	//FrameScheduler parts (diagnosticsReport_t of the sketch)
+	static const uint8_t featureIDs[] = { 2, 3, 4, 5 };
+	static const uint8_t featureSizes[] = { sizeof(signalStatsReport_t) - 1, sizeof(mappingUploadReport_t) - 1,
+	                                        sizeof(memoryReport_t) - 1,
+	                                        2 * sizeof(uint16_t) + sizeof(ppmDiagnostics) + sizeof(frameLatencies) };
+	(void)config;
+	(void)duration;
+
+	JoystickReport report;
+	bool added = true;
+	for (uint8_t i = 0; i < sizeof(featureIDs); i++) {
+		added = report.addFeatureReport(featureIDs[i], featureSizes[i]) && added;
+	}
+	descriptorResult result;
+	parseDescriptor(report.GetDescriptor(), report.GetDescriptorSize(), result);
+	printf("Descriptor: %u bytes, input report %u bytes, %u input fields\n", report.GetDescriptorSize(),
+	       report.GetReportSize(), (unsigned)result.inputs.size());
+
+	simCheck(added, "every feature report added");
+	simCheck(report.GetDescriptorSize() < JOYSTICKREPORT_MAX_DESCRIPTOR_SIZE, "descriptor not truncated");
+	simCheck(!result.malformed && result.openCollections == 0, "descriptor items and collections well formed");
+
+	//report sizes per ID
+	simCheck(result.inputBits[report.reportID] == 8u * (report.GetReportSize() - 1),
+	         "input report %u: %u bits, GetReportSize() %u bytes", report.reportID, result.inputBits[report.reportID],
+	         report.GetReportSize());
+	for (uint8_t i = 0; i < sizeof(featureIDs); i++) {
+		simCheck(result.featureBits[featureIDs[i]] == 8u * featureSizes[i] && result.inputBits[featureIDs[i]] == 0,
+		         "feature report %u: %u bits, added with %u bytes", featureIDs[i], result.featureBits[featureIDs[i]],
+		         featureSizes[i]);
+	}
+	simCheck(result.featuresOutsideVendor == 0 && result.inputsInVendor == 0,
+	         "feature reports in the vendor application collection, inputs outside it");
+
+	//axes: usages, range and the bytes of setAxis()
+	uint8_t* buffer = report.GetReport();
+	bool axesOk = true;
+	for (uint8_t i = 0; i < JOYSTICKREPORT_AXES; i++) {
+		const descriptorField* field = findField(result, 0x01, axisUsages[i]);
+		report.setAxis(i, 0x1234 + 0x101 * i);
+		axesOk = axesOk && field != NULL && field->size == 16 && field->reportID == report.reportID
+		         && field->logicalMinimum == JOYSTICKREPORT_AXIS_MIN && field->logicalMaximum == JOYSTICKREPORT_AXIS_MAX
+		         && readField(buffer, *field) == 0x1234u + 0x101 * i;
+	}
+	simCheck(axesOk, "%u axes: 16 bits, logical %d..%d, at the offsets setAxis() writes", JOYSTICKREPORT_AXES,
+	         JOYSTICKREPORT_AXIS_MIN, JOYSTICKREPORT_AXIS_MAX);
+
+#if JOYSTICKREPORT_BUTTONS > 0
+	bool buttonsOk = true;
+	for (uint8_t b = 1; b <= JOYSTICKREPORT_BUTTONS; b++) {
+		const descriptorField* field = findField(result, 0x09, b);
+		report.setButton(b, true);
+		bool set = field != NULL && field->size == 1 && readField(buffer, *field) == 1;
+		report.setButton(b, false);
+		buttonsOk = buttonsOk && set && readField(buffer, *field) == 0;
+	}
+	simCheck(buttonsOk, "%u buttons at the bits setButton() writes", JOYSTICKREPORT_BUTTONS);
+#endif
+
+#if JOYSTICKREPORT_HATS > 0
+	bool hatsOk = true;
+	for (uint8_t h = 0; h < JOYSTICKREPORT_HATS; h++) {
+		const descriptorField* field = findField(result, 0x01, 0x39, h);
+		report.setHat(h, 90);
+		bool set = field != NULL && field->size == 4 && field->logicalMaximum == 7 && readField(buffer, *field) == 2;
+		report.setHat(h, -1);
+		hatsOk = hatsOk && set && readField(buffer, *field) == JOYSTICKREPORT_HAT_CENTERED;
+	}
+	simCheck(hatsOk, "%u hats at the bits setHat() writes, centered out of the logical range", JOYSTICKREPORT_HATS);
+#endif
+}
@@ -0,0 +1,171 @@
+/*
+ChannelMapper benchmark of the virtual-time simulator.
+
+The table driven mapping (ChannelMapper::apply()) against the hard-coded mapping it replaced
+(axes 1..8 from Ch1..Ch8 through the calibration, buttons 1 and 2 pressed above the calibrated centre
+of Ch7 and Ch8), on the same random frames (no sketch):
+ - the host time per frame of both, the best of MAPPER_RUNS runs (a host measure, the ratio is what matters)
+ - checks: with an equivalent table (no hysteresis) both give the same report for every frame,
+   the table costs no more than the hard-coded mapping (within MAPPER_MARGIN, the run to run noise of the host),
+   a button threshold below its hysteresis is rejected, a rejected table is left as uploaded,
+   the controls a new table does not drive are neutral
+e.g. ppm_simulator --scenario=mapper
+
+=================================================================
+(C) 2026 ifh
+This file is part of PPM to USB Joystick.
+
+PPM to USB Joystick is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+PPM to USB Joystick is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+
+#include "Arduino.h"
+#include "RadioProfiles.h"
+#include "ChannelCalibration.h"
+#include "ChannelMapper.h"
+#include "JoystickReport.h"
+#include "SimTest.h"
+
+#define MAPPER_CHANNELS 8
+#define MAPPER_RUNS 25
+//The host times of the best runs still differ by a few percent from run to run
+#define MAPPER_MARGIN 1.10
+
+//The hard-coded mapping before the mapping table
+static void hardCodedMapping(const uint16_t* channels, JoystickReport* report, ChannelCalibration* calibration) {
+	static const uint8_t axisChannels[JOYSTICKREPORT_AXES] = {1, 2, 3, 4, 5, 6, 7, 8};
+	static const uint8_t buttonChannels[JOYSTICKREPORT_BUTTONS] = {7, 8};
+	for (uint8_t i = 0; i < JOYSTICKREPORT_AXES; ++i) {
+		if (axisChannels[i] != 0 && axisChannels[i] <= MAPPER_CHANNELS) {
+			report->setAxis(i, calibration->map(axisChannels[i], channels[axisChannels[i]]));
+		}
+	}
+	for (uint8_t i = 0; i < JOYSTICKREPORT_BUTTONS; ++i) {
+		if (buttonChannels[i] != 0 && buttonChannels[i] <= MAPPER_CHANNELS) {
+			report->setButton(i + 1, (channels[buttonChannels[i]] > calibration->GetCentre(buttonChannels[i])));
+		}
+	}
+}
+
+
+void mapperBenchmark(const generatorConfig& config, uint32_t duration) {
+	static const mappingEntry table[] = {
+	    {1, MAPPING_AXIS, 0, 0, 0, 0, 0}, {2, MAPPING_AXIS, 1, 0, 0, 0, 0}, {3, MAPPING_AXIS, 2, 0, 0, 0, 0},
+	    {4, MAPPING_AXIS, 3, 0, 0, 0, 0}, {5, MAPPING_AXIS, 4, 0, 0, 0, 0}, {6, MAPPING_AXIS, 5, 0, 0, 0, 0},
+	    {7, MAPPING_AXIS, 6, 0, 0, 0, 0}, {8, MAPPING_AXIS, 7, 0, 0, 0, 0},
+	    {7, MAPPING_BUTTON, 1, 0, 0, 0, 0}, {8, MAPPING_BUTTON, 2, 0, 0, 0, 0}
+	};
+	ChannelCalibration calibration;
+	ChannelMapper mapper;
+	JoystickReport hardCoded;
+	JoystickReport mapped;
+	calibration.channelAmount = MAPPER_CHANNELS;
+	mapper.channelAmount = MAPPER_CHANNELS;
+	bool tableSet = mapper.setTable(table, sizeof(table) / sizeof(table[0]));
+
+	//random frames within the stick range
+	uint32_t frames = duration / config.frameLength;
+	std::vector<uint16_t> values(frames * (MAPPER_CHANNELS + 1));
+	uint32_t random = (config.seed != 0) ? config.seed : 1;
+	for (uint32_t k = 0; k < values.size(); k++) {
+		random ^= random << 13;
+		random ^= random >> 17;
+		random ^= random << 5;
+		values[k] = activeRadio.minNormalChannelValue
+		            + random % (activeRadio.maxNormalChannelValue - activeRadio.minNormalChannelValue + 1);
+	}
+
+	//the same report for every frame
+	uint32_t mismatches = 0;
+	for (uint32_t k = 0; k < frames; k++) {
+		const uint16_t* channels = &values[k * (MAPPER_CHANNELS + 1)];
+		hardCodedMapping(channels, &hardCoded, &calibration);
+		mapper.apply(channels, &mapped, &calibration);
+		if (memcmp(hardCoded.GetReport(), mapped.GetReport(), hardCoded.GetReportSize()) != 0) {
+			++mismatches;
+		}
+	}
+
+	//the time of all frames, the best of a few runs
+	double hardCodedTime = 0;
+	double mappedTime = 0;
+	for (uint8_t run = 0; run < MAPPER_RUNS; run++) {
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		for (uint32_t k = 0; k < frames; k++) {
+			hardCodedMapping(&values[k * (MAPPER_CHANNELS + 1)], &hardCoded, &calibration);
+		}
+		std::chrono::steady_clock::time_point middle = std::chrono::steady_clock::now();
+		for (uint32_t k = 0; k < frames; k++) {
+			mapper.apply(&values[k * (MAPPER_CHANNELS + 1)], &mapped, &calibration);
+		}
+		std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+		double time = std::chrono::duration<double, std::nano>(middle - start).count() / frames;
+		hardCodedTime = (run == 0 || time < hardCodedTime) ? time : hardCodedTime;
+		time = std::chrono::duration<double, std::nano>(end - middle).count() / frames;
+		mappedTime = (run == 0 || time < mappedTime) ? time : mappedTime;
+	}
+
+	printf("Mapper: %u frames, %u table entries\n", frames, mapper.GetTableSize());
+	printf("  hard-coded mapping %.0fns per frame, mapping table %.0fns per frame (host), ratio %.2f\n",
+	       hardCodedTime, mappedTime, hardCodedTime > 0 ? mappedTime / hardCodedTime : 0);
+
+	simCheck(tableSet, "the equivalent table is set");
+	simCheck(mismatches == 0, "the same report as the hard-coded mapping for every frame, %u mismatches", mismatches);
+	simCheck(mappedTime <= hardCodedTime * MAPPER_MARGIN, "the mapping table costs at most the hard-coded mapping (x%.2f)",
+	         MAPPER_MARGIN);
+
+	//the release level of a button would be below 0
+	static const mappingEntry invalid[] = { {7, MAPPING_BUTTON, 1, 0, 5, 10, 0} };
+	uint32_t errors = mapper.GetUploadErrors();
+	simCheck(!mapper.setTable(invalid, 1) && mapper.GetUploadErrors() == errors + 1,
+	         "a button threshold below its hysteresis is rejected");
+
+	//all sticks at the top, buttons 1 and 2 pressed
+	std::vector<uint16_t> high(MAPPER_CHANNELS + 1, activeRadio.maxNormalChannelValue);
+	mapper.setTable(table, sizeof(table) / sizeof(table[0]));
+	mapper.apply(&high[0], &mapped, &calibration);
+
+	//an upload with a dropped entry (Ch9) and an invalid one, then the invalid entry is written again
+	mappingUploadReport_t upload;
+	memset(&upload, 0, sizeof(upload));
+	upload.command = CHANNELMAPPER_COMMAND_WRITE;
+	upload.count = 3;
+	upload.entries[0] = {9, MAPPING_AXIS, 8, 0, 0, 0, 0};
+	upload.entries[1] = {2, MAPPING_AXIS, 1, 0, 0, 0, 0};
+	upload.entries[2] = invalid[0];
+	mapper.receive((const uint8_t*)&upload, sizeof(upload));
+	mappingUploadReport_t commit;
+	memset(&commit, 0, sizeof(commit));
+	commit.command = CHANNELMAPPER_COMMAND_COMMIT;
+	commit.count = 3;
+	bool rejected = !mapper.receive((const uint8_t*)&commit, 4);
+	upload.offset = 2;
+	upload.count = 1;
+	upload.entries[0] = {7, MAPPING_BUTTON, 1, 0, 10, 5, 0};
+	mapper.receive((const uint8_t*)&upload, sizeof(upload));
+	bool committed = mapper.receive((const uint8_t*)&commit, 4);
+	mapper.apply(&high[0], &mapped, &calibration);
+	simCheck(rejected && committed && mapper.GetTableSize() == 2 && mapper.GetEntry(0)->source == 2
+	         && mapper.GetEntry(1)->source == 7, "a rejected upload is left as written, it is committed after a fix");
+
+	//the new table drives axis 1 and button 1 only
+	const joystickReport_t* report = (const joystickReport_t*)mapped.GetReport();
+	simCheck(report->axes[0] == (JOYSTICKREPORT_AXIS_MAX - JOYSTICKREPORT_AXIS_MIN) / 2 && report->axes[1] == JOYSTICKREPORT_AXIS_MAX
+	         && (report->buttons[0] & 0x03) == 0x01, "the axes and buttons the new table does not drive are neutral");
+}
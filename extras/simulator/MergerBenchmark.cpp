@@ -0,0 +1,198 @@
+/*
+PPMMerger benchmark of the virtual-time simulator.
+
+Up to 4 generated PPM streams, each at its own frame rate (1, 0.9, 0.8 and 1.2 times --frame-length)
+and with its own channel values (1100, 1200, 1300, 1400 us), drive 4 PPMReaders which are merged
+by PPMMerger, channel i from the input (i-1) % inputs. A dropout (--dropout-period, --dropout-length)
+is applied to the stream of input 0 only, so the other inputs take over its channels.
+The merger is read every --loop-cost us, it is run with 1, 2, 3 and 4 inputs:
+ - the merged frames against the frames of input 0, which paces the output while it is healthy
+ - the host time of readMerged() per call and per merged frame (a host measure, the ratio of the
+   input counts is what matters), the channel reads per call (noInterrupts() calls, one per channel
+   of a frame read from an input - the cost on the target, where each one toggles the interrupts)
+ - checks: every merged channel has the value of the input it is taken from and that input is healthy,
+   a merged frame carries the timestamp of the input 0 frame while input 0 is healthy (the other
+   inputs do not delay the primary stick path), no gap of the output longer than the input timeout,
+   every input frame is read at most once (the channel reads are at most the channels of the input frames)
+e.g. ppm_simulator --scenario=merger
+
+=================================================================
+(C) 2026 ifh
+This file is part of PPM to USB Joystick.
+
+PPM to USB Joystick is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+PPM to USB Joystick is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+*/
+
+#include <stdio.h>
+#include <chrono>
+
+#include "Arduino.h"
+#include "PPMReader.h"
+#include "PPMMerger.h"
+#include "SimTest.h"
+
+#define MERGER_FIRST_PIN 50
+
+typedef struct mergerResult {
+    uint32_t calls = 0;
+    uint32_t mergedFrames = 0;
+    uint32_t primaryFrames = 0;      //frames of input 0
+    uint32_t valueMismatches = 0;    //a channel without the value of its input or from an unhealthy input
+    uint32_t primaryDelayed = 0;     //a merged frame without the timestamp of the input 0 frame while it is healthy
+    uint32_t takeovers = 0;          //merged frames with a channel taken over from an unhealthy input
+    uint32_t maxGap = 0;
+    uint32_t inputFrames = 0;        //frames of all inputs
+    uint32_t channelReads = 0;       //noInterrupts() calls in readMerged()
+    double callTime = 0;             //ns
+    double mergeTime = 0;            //ns, calls which produced a frame
+} mergerResult;
+
+
+static void mergerRun(const generatorConfig& config, uint32_t duration, uint32_t loopCost, uint8_t inputs, mergerResult& result) {
+	static const float rates[PPMMERGER_MAX_INPUTS] = { 1.0f, 0.9f, 0.8f, 1.2f };
+	PPMGenerator* generators[PPMMERGER_MAX_INPUTS];
+	PPMReader* readers[PPMMERGER_MAX_INPUTS];
+	PPMMerger merger;
+	merger.channelAmount = config.channelAmount;
+
+	for (uint8_t k = 0; k < inputs; k++) {
+		generatorConfig stream = config;
+		stream.frameLength = (uint32_t)(config.frameLength * rates[k]);
+		stream.channelValue = 1100 + 100 * k;
+		stream.stepChannel = 0;
+		stream.seed = config.seed + k;
+		if (k != 0) {
+			stream.dropoutPeriod = 0;
+		}
+		generators[k] = new PPMGenerator(stream);
+		readers[k] = new PPMReader(config.channelAmount);
+		simSetPinLevel(MERGER_FIRST_PIN + k, generators[k]->GetIdleLevel());
+		readers[k]->setupInterrupt(MERGER_FIRST_PIN + k, INVERTED);
+		merger.addInput(readers[k]);
+	}
+	for (uint8_t i = 1; i <= config.channelAmount; i++) {
+		merger.setChannelRule(i, (i - 1) % inputs, (i - 1) % inputs);
+	}
+
+	uint16_t channels[PPMMERGER_MAX_CHANNELS + 1];
+	uint32_t lastMerged = 0;
+	for (uint32_t now = 0; now < duration; now += loopCost) {
+		//the edges of all streams up to now, in time order
+		while (true) {
+			int8_t next = -1;
+			for (uint8_t k = 0; k < inputs; k++) {
+				if (generators[k]->peekEdge().time <= now
+				    && (next < 0 || generators[k]->peekEdge().time < generators[next]->peekEdge().time)) {
+					next = k;
+				}
+			}
+			if (next < 0) {
+				break;
+			}
+			ppmEdge edge = generators[next]->peekEdge();
+			generators[next]->popEdge();
+			simSetTime(edge.time);
+			simSetPinLevel(MERGER_FIRST_PIN + next, edge.level);
+		}
+		simSetTime(now);
+
+		uint32_t reads = simNoInterruptsCalls;
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		uint32_t timeStamp = merger.readMerged(channels);
+		double time = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+		result.channelReads += simNoInterruptsCalls - reads;
+		++result.calls;
+		result.callTime += time;
+		if (timeStamp == 0) {
+			continue;
+		}
+		result.mergeTime += time;
+		++result.mergedFrames;
+		if (lastMerged != 0 && now - lastMerged > result.maxGap) {
+			result.maxGap = now - lastMerged;
+		}
+		lastMerged = now;
+
+		uint8_t healthy = merger.GetHealthyInputs();
+		bool takeover = false;
+		for (uint8_t i = 1; i <= config.channelAmount; i++) {
+			uint8_t input = merger.GetActiveInput(i);
+			//the edge jitter of both ends of a channel
+			if (abs((int32_t)channels[i] - (int32_t)(1100 + 100 * input)) > 2 * config.jitter || (healthy & (1 << input)) == 0) {
+				++result.valueMismatches;
+			}
+			takeover = takeover || input != (i - 1) % inputs;
+		}
+		if (takeover) {
+			++result.takeovers;
+		}
+		if ((healthy & 1) != 0 && timeStamp != readers[0]->GetDataInputTimeStamp()) {
+			++result.primaryDelayed;
+		}
+	}
+	result.primaryFrames = readers[0]->GetFrameCount();
+	for (uint8_t k = 0; k < inputs; k++) {
+		result.inputFrames += readers[k]->GetFrameCount() + readers[k]->GetSignalLossCount();
+	}
+
+	for (uint8_t k = 0; k < inputs; k++) {
+		delete readers[k];
+		delete generators[k];
+	}
+}
+
+
+void mergerBenchmark(const generatorConfig& config, uint32_t duration) {
+	uint32_t loopCost = simOption("loop-cost", 100);
+	double mergeTimes[PPMMERGER_MAX_INPUTS + 1];
+	PPMMerger merger;
+	printf("Merger: %u channels, loop() every %uus\n", config.channelAmount, loopCost);
+
+	//a short run first, so the first timed run is not the one which warms the caches up
+	mergerResult warmUp;
+	mergerRun(config, duration / 10, loopCost, 1, warmUp);
+
+	for (uint8_t inputs = 1; inputs <= PPMMERGER_MAX_INPUTS; inputs++) {
+		mergerResult result;
+		mergerRun(config, duration, loopCost, inputs, result);
+		mergeTimes[inputs] = result.mergedFrames > 0 ? result.mergeTime / result.mergedFrames : 0;
+		printf("  %u inputs: %u merged frames (input 0: %u frames, %u with a takeover), longest gap %uus, "
+		       "%.0fns per call, %.0fns per merged frame, %.2f channel reads per call\n", inputs, result.mergedFrames,
+		       result.primaryFrames, result.takeovers, result.maxGap, result.callTime / result.calls, mergeTimes[inputs],
+		       (double)result.channelReads / result.calls);
+
+		simCheck(result.valueMismatches == 0, "%u inputs: every channel from a healthy input with its value", inputs);
+		simCheck(result.primaryDelayed == 0, "%u inputs: a merged frame is the input 0 frame while input 0 is healthy", inputs);
+		simCheck(result.channelReads <= result.inputFrames * config.channelAmount,
+		         "%u inputs: %u channel reads for %u input frames, each frame is read once", inputs,
+		         result.channelReads, result.inputFrames);
+		if (config.dropoutPeriod == 0 || inputs > 1) {
+			simCheck(result.maxGap <= merger.inputTimeout + 2 * config.frameLength, "%u inputs: longest gap of the output %uus",
+			         inputs, result.maxGap);
+		}
+		if (config.dropoutPeriod == 0) {
+			simCheck(result.mergedFrames + 1 >= result.primaryFrames && result.mergedFrames <= result.primaryFrames,
+			         "%u inputs: one merged frame per input 0 frame", inputs);
+		}
+		else if (inputs > 1) {
+			simCheck(result.takeovers > 0, "%u inputs: the other inputs take over during the input 0 dropouts", inputs);
+		}
+	}
+	printf("  merge cost, 4 inputs / 1 input: %.2f\n", mergeTimes[1] > 0 ? mergeTimes[PPMMERGER_MAX_INPUTS] / mergeTimes[1] : 0);
+
+	//a reader with more channels than the frame buffers is rejected
+	PPMReader wide(PPMMERGER_MAX_CHANNELS + 1);
+	simCheck(merger.addInput(&wide) == -1, "an input with more than %u channels is rejected", PPMMERGER_MAX_CHANNELS);
+}
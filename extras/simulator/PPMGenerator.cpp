@@ -0,0 +1,115 @@
+/*
+PPM signal generator for the virtual-time simulator.
+
+=================================================================
+(C) 2026 ifh
+This file is part of PPM to USB Joystick.
+
+PPM to USB Joystick is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+PPM to USB Joystick is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+*/
+
+#include "PPMGenerator.h"
+
+PPMGenerator::PPMGenerator(const generatorConfig& config) {
+	_config = config;
+	if (_config.channelAmount > PPMGENERATOR_MAX_CHANNELS) {
+		_config.channelAmount = PPMGENERATOR_MAX_CHANNELS;
+	}
+	//start after the sketch setup() has completed
+	_frameStart = 10000;
+	_frameNumber = 0;
+	_random = (config.seed != 0) ? config.seed : 1;
+}
+
+
+uint8_t PPMGenerator::GetIdleLevel() {
+	return _config.inverted ? 1 : 0;
+}
+
+
+/* Function to return a uniform random jitter, xorshift32 */
+int32_t PPMGenerator::nextJitter() {
+	if (_config.jitter == 0) {
+		return 0;
+	}
+	_random ^= _random << 13;
+	_random ^= _random >> 17;
+	_random ^= _random << 5;
+	return (int32_t)(_random % (2 * _config.jitter + 1)) - _config.jitter;
+}
+
+
+/* Function to generate the edges of the next frame */
+void PPMGenerator::generateFrame() {
+	uint32_t start = _frameStart;
+	_frameStart += _config.frameLength;
+	++_frameNumber;
+
+	//No edges during a dropout
+	if (_config.dropoutPeriod != 0 && start > _config.dropoutPeriod
+	    && (start % _config.dropoutPeriod) < _config.dropoutLength) {
+		return;
+	}
+
+	generatedFrame frame;
+	frame.failsafe = _config.failsafePeriod != 0 && start > _config.failsafePeriod
+	                 && (start % _config.failsafePeriod) < _config.failsafeLength;
+	frame.values[0] = 0;
+	for (uint8_t i = 1; i <= _config.channelAmount; i++) {
+		frame.values[i] = _config.channelValue;
+		if (i == _config.stepChannel && _config.stepPeriod != 0) {
+			frame.values[i] = ((start / _config.stepPeriod) % 2) ? _config.stepHigh : _config.stepLow;
+		}
+		if (frame.failsafe) {
+			frame.values[i] = _config.failsafeValue;
+		}
+	}
+
+	//A separator pulse starts every channel and one more ends the last channel
+	uint8_t activeLevel = _config.inverted ? 0 : 1;
+	uint32_t slot = start;
+	for (uint8_t i = 0; i <= _config.channelAmount; i++) {
+		ppmEdge leading = { slot + nextJitter(), activeLevel };
+		ppmEdge trailing = { slot + _config.separatorLength + nextJitter(), (uint8_t)(1 - activeLevel) };
+		_edges.push_back(leading);
+		_edges.push_back(trailing);
+		frame.edgeTimes[i] = leading.time;
+		if (i == 0 && _config.spikeFrames != 0 && _frameNumber % _config.spikeFrames == 0) {
+			uint32_t spike = slot + frame.values[1] / 2;
+			ppmEdge spikeLeading = { spike, activeLevel };
+			ppmEdge spikeTrailing = { spike + _config.spikeLength, (uint8_t)(1 - activeLevel) };
+			_edges.push_back(spikeLeading);
+			_edges.push_back(spikeTrailing);
+		}
+		if (i < _config.channelAmount) {
+			slot += frame.values[i + 1];
+		}
+	}
+	frames.push_back(frame);
+}
+
+
+ppmEdge PPMGenerator::peekEdge() {
+	while (_edges.empty()) {
+		generateFrame();
+	}
+	return _edges.front();
+}
+
+void PPMGenerator::popEdge() {
+	if (!_edges.empty()) {
+		_edges.pop_front();
+	}
+}
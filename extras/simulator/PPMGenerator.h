@@ -0,0 +1,107 @@
+/*
+PPM signal generator for the virtual-time simulator.
+
+Generates PPM frames as a list of pin level changes (edges) with configurable
+channel count, frame length, edge jitter, noise spikes, signal dropouts and failsafe bursts
+(all channels at failsafeValue, as a Walkera receiver does when the signal is lost).
+One channel can be stepped periodically between two values to measure the filter delay.
+Random jitter is deterministic for a given seed.
+
+=================================================================
+(C) 2026 ifh
+This file is part of PPM to USB Joystick.
+
+PPM to USB Joystick is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+PPM to USB Joystick is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+*/
+
+#ifndef SIMULATOR_PPMGENERATOR_H
+#define SIMULATOR_PPMGENERATOR_H
+
+#include <stdint.h>
+#include <deque>
+#include <vector>
+
+#define PPMGENERATOR_MAX_CHANNELS 16
+
+typedef struct generatorConfig {
+    uint8_t channelAmount = 8;       //channels in a frame
+    uint32_t frameLength = 22500;    //microseconds
+    uint16_t separatorLength = 400;  //separator pulse length, microseconds
+    uint16_t jitter = 0;             //maximum edge jitter in either direction, microseconds
+    bool inverted = true;            //separator pulses are LOW, the signal is HIGH when idle
+    uint16_t channelValue = 1500;    //value of the channels which are not stepped, microseconds
+
+    //Periodic step on a channel, stepChannel = 0 - no step
+    uint8_t stepChannel = 1;
+    uint16_t stepLow = 1300;
+    uint16_t stepHigh = 1700;
+    uint32_t stepPeriod = 500000;    //microseconds
+
+    //Signal dropouts - no edges at all for dropoutLength every dropoutPeriod, 0 - none
+    uint32_t dropoutPeriod = 0;
+    uint32_t dropoutLength = 0;
+
+    //Failsafe bursts - all channels at failsafeValue for failsafeLength every failsafePeriod, 0 - none
+    uint32_t failsafePeriod = 0;
+    uint32_t failsafeLength = 0;
+    uint16_t failsafeValue = 800;
+
+    //Noise spikes - a spikeLength pulse at the active level in the middle of channel 1 every spikeFrames frames, 0 - none
+    uint32_t spikeFrames = 0;
+    uint16_t spikeLength = 20;
+
+    uint32_t seed = 1;
+} generatorConfig;
+
+typedef struct ppmEdge {
+    uint32_t time;
+    uint8_t level;
+} ppmEdge;
+
+typedef struct generatedFrame {
+    //Channel values, indexed {1..channelAmount}
+    uint16_t values[PPMGENERATOR_MAX_CHANNELS + 1];
+    //Times of the separator leading edges, edge i ends channel i, edge 0 starts the frame
+    uint32_t edgeTimes[PPMGENERATOR_MAX_CHANNELS + 1];
+    bool failsafe;
+} generatedFrame;
+
+
+class PPMGenerator {
+	public:
+		PPMGenerator(const generatorConfig& config);
+
+		//Returns the next edge, frames are generated as needed
+		ppmEdge peekEdge();
+		void popEdge();
+
+		//All generated frames, in time order
+		std::vector<generatedFrame> frames;
+
+		//Level of the signal when idle
+		uint8_t GetIdleLevel();
+
+	private:
+		generatorConfig _config;
+		std::deque<ppmEdge> _edges;
+		uint32_t _frameStart;
+		uint32_t _frameNumber;
+		uint32_t _random;
+
+		void generateFrame();
+		int32_t nextJitter();
+};
+
+#endif
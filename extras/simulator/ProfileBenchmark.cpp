@@ -0,0 +1,85 @@
+/*
+Radio profile benchmark of the virtual-time simulator.
+
+A generated PPM signal is decoded by a PPMReader (no sketch), the host time of the edge interrupts
+and of readNormalisedInteger() is measured per frame. Build the simulator with and without
+-DRADIO_PROFILE_STATIC to compare the compile time profile with the run time PPMReader fields, e.g.
+  ppm_simulator --scenario=profile
+The object size is printed as well, the flash size of PPMReader is in the linker map (extras/tools/memory_map.py).
+
+=================================================================
+(C) 2026 ifh
+This file is part of PPM to USB Joystick.
+
+PPM to USB Joystick is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+PPM to USB Joystick is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+*/
+
+#include <stdio.h>
+#include <chrono>
+
+#include "Arduino.h"
+#include "PPMReader.h"
+#include "SimTest.h"
+
+#define PROFILE_PIN 43
+
+void profileBenchmark(const generatorConfig& config, uint32_t duration) {
+	PPMGenerator generator(config);
+	PPMReader reader(config.channelAmount);
+	uint16_t channels[PPMREADER_MAX_CHANNELS + 1];
+	uint32_t frames = 0;
+	uint32_t outOfRange = 0;
+	uint32_t lastTimeStamp = 0;
+	double edgeTime = 0;
+	double readTime = 0;
+
+	simSetPinLevel(PROFILE_PIN, generator.GetIdleLevel());
+	reader.setupInterrupt(PROFILE_PIN, config.inverted ? INVERTED : NORMAL);
+
+	while (generator.peekEdge().time < duration) {
+		ppmEdge edge = generator.peekEdge();
+		generator.popEdge();
+		simSetTime(edge.time);
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		simSetPinLevel(PROFILE_PIN, edge.level);
+		edgeTime += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+		if (!reader.IsDataReady() || reader.GetDataInputTimeStamp() == lastTimeStamp) {
+			continue;
+		}
+		start = std::chrono::steady_clock::now();
+		lastTimeStamp = reader.readNormalisedInteger(channels);
+		readTime += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+		++frames;
+		for (uint8_t i = 1; i <= config.channelAmount; i++) {
+			if (channels[i] < reader.minChannelValue || channels[i] > reader.maxChannelValue) {
+				++outOfRange;
+			}
+		}
+	}
+
+#ifdef RADIO_PROFILE_STATIC
+	const char* profile = "compile time (RADIO_PROFILE_STATIC)";
+#else
+	const char* profile = "run time fields";
+#endif
+	uint32_t generated = generator.frames.size();
+	printf("Radio profile: %s, sizeof(PPMReader) %u bytes\n", profile, (unsigned)sizeof(PPMReader));
+	printf("  %u frames of %u: edge interrupts %.0fns, readNormalisedInteger() %.0fns per frame (host)\n",
+	       frames, generated, frames > 0 ? edgeTime / frames : 0, frames > 0 ? readTime / frames : 0);
+
+	simCheck(frames + 2 >= generated, "every frame decoded, %u of %u", frames, generated);
+	simCheck(outOfRange == 0, "normalised values within the profile range");
+}
@@ -0,0 +1,121 @@
+/*
+Resolution test of the virtual-time simulator.
+
+Ch1 ramps slowly from the centre, the samples are the ramp plus a uniform jitter rounded to whole us
+(as PPMReader measures them) and go through MedianFilter and ChannelCalibration (no sketch).
+The axis from the median (whole us) and from the fractional output (1/16 us) is compared with the ideal axis
+of the ramp, which is the ramp delayed by the filter (half of the window): rms error, effective resolution
+(an ideal quantiser step with the same rms error) and the number of distinct axis values, e.g.
+  ppm_simulator --scenario=resolution --ramp=20 --jitter=1
+
+=================================================================
+(C) 2026 ifh
+This file is part of PPM to USB Joystick.
+
+PPM to USB Joystick is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+PPM to USB Joystick is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+*/
+
+#include <stdio.h>
+#include <math.h>
+
+#include "Arduino.h"
+#include "RadioProfiles.h"
+#include "MedianFilter.h"
+#include "ChannelCalibration.h"
+#include "JoystickReport.h"
+#include "SimTest.h"
+
+typedef struct resolutionResult {
+    double sumSquares = 0;
+    uint32_t samples = 0;
+    uint32_t levels = 0;
+    uint16_t lastAxis = 0;
+} resolutionResult;
+
+static void resolutionSample(resolutionResult& result, uint16_t axis, double ideal) {
+	double error = axis - ideal;
+	result.sumSquares += error * error;
+	if (result.samples == 0 || axis != result.lastAxis) {
+		++result.levels;
+	}
+	result.lastAxis = axis;
+	++result.samples;
+}
+
+static double resolutionRms(const resolutionResult& result) {
+	return (result.samples > 0) ? sqrt(result.sumSquares / result.samples) : 0;
+}
+
+static void printResolution(const char* name, const resolutionResult& result, double countsPerUs) {
+	double rms = resolutionRms(result);
+	printf("%s: axis error rms=%.1f (%.3fus), effective resolution %.3fus, %u axis values\n", name, rms,
+	       rms / countsPerUs, sqrt(12.0) * rms / countsPerUs, result.levels);
+}
+
+
+void resolutionTest(const generatorConfig& config, uint32_t duration) {
+	uint32_t rampSpan = simOption("ramp", 20);
+	uint32_t jitter = config.jitter;
+	MedianFilter filter;
+	ChannelCalibration calibration;
+	filter.channelAmountIn = 1;
+	filter.channelAmountOut = 1;
+	calibration.channelAmount = 1;
+	calibration.minOutputValue = JOYSTICKREPORT_AXIS_MIN;
+	calibration.maxOutputValue = JOYSTICKREPORT_AXIS_MAX;
+
+	uint16_t in[2];
+	uint16_t out[2];
+	uint16_t outQ4[2];
+	resolutionResult median;
+	resolutionResult fractional;
+	uint32_t random = (config.seed != 0) ? config.seed : 1;
+	uint32_t frames = duration / config.frameLength;
+	double start = activeRadio.channelMidPoint;
+	//the ideal axis, the Q16 scale of calibration in double
+	double countsPerUs = (calibration.map(1, activeRadio.channelMidPoint + 100) - calibration.map(1, activeRadio.channelMidPoint)) / 100.0;
+	double centreAxis = calibration.map(1, activeRadio.channelMidPoint);
+
+	for (uint32_t k = 0; k < frames; k++) {
+		double value = start + (double)rampSpan * k / frames;
+		int32_t noise = 0;
+		if (jitter != 0) {
+			random ^= random << 13;
+			random ^= random >> 17;
+			random ^= random << 5;
+			noise = (int32_t)(random % (2 * jitter + 1)) - (int32_t)jitter;
+		}
+		in[0] = filter.codeFailSafe + 1;
+		in[1] = (uint16_t)floor(value + noise + 0.5);
+		filter.ApplyFilter(in, out, 1 + k * config.frameLength, outQ4);
+
+		//skip the start, the window is filled with the first frame
+		if (k < MEDIANFILTER_MAX_WINDOW) {
+			continue;
+		}
+		double delayed = start + (double)rampSpan * (k - (filter.GetWindowSize() - 1) / 2.0) / frames;
+		double ideal = centreAxis + (delayed - activeRadio.channelMidPoint) * countsPerUs;
+		resolutionSample(median, calibration.map(1, out[1]), ideal);
+		resolutionSample(fractional, calibration.mapQ4(1, outQ4[1]), ideal);
+	}
+
+	printf("Resolution test: ramp %uus over %u frames, jitter %uus, window %u, trim %u\n", rampSpan, frames, jitter,
+	       filter.GetWindowSize(), filter.trimPoints);
+	printResolution("Median, whole us", median, countsPerUs);
+	printResolution("Trimmed mean, 1/16 us", fractional, countsPerUs);
+
+	simCheck(resolutionRms(fractional) < resolutionRms(median), "fractional axis rms error < median axis rms error");
+	simCheck(fractional.levels > median.levels, "fractional axis has more distinct values than the median axis");
+}
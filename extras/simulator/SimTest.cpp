@@ -0,0 +1,88 @@
+/*
+Options and checks of the simulator scenarios.
+
+=================================================================
+(C) 2026 ifh
+This file is part of PPM to USB Joystick.
+
+PPM to USB Joystick is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+PPM to USB Joystick is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+*/
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "SimTest.h"
+
+static std::vector<std::string> options;
+static uint32_t failures = 0;
+
+
+void simSetOptions(const char* scenarioOptions, int argc, char** argv) {
+	options.clear();
+	std::string word;
+	for (const char* c = scenarioOptions; c != NULL; c++) {
+		if (*c == ' ' || *c == '\0') {
+			if (!word.empty()) {
+				options.push_back(word);
+				word.clear();
+			}
+			if (*c == '\0') {
+				break;
+			}
+		}
+		else
+		{
+			word += *c;
+		}
+	}
+	for (int i = 1; i < argc; i++) {
+		options.push_back(argv[i]);
+	}
+}
+
+
+uint32_t simOption(const char* name, uint32_t defaultValue) {
+	size_t length = strlen(name);
+	for (size_t i = options.size(); i-- > 0;) {
+		const char* option = options[i].c_str();
+		if (strncmp(option, "--", 2) == 0 && strncmp(option + 2, name, length) == 0 && option[2 + length] == '=') {
+			return (uint32_t)strtoul(option + 3 + length, NULL, 10);
+		}
+	}
+	return defaultValue;
+}
+
+
+bool simCheck(bool condition, const char* format, ...) {
+	va_list args;
+	va_start(args, format);
+	printf("  check: ");
+	vprintf(format, args);
+	printf(" - %s\n", condition ? "ok" : "FAILED");
+	va_end(args);
+	if (!condition) {
+		++failures;
+	}
+	return condition;
+}
+
+
+uint32_t simCheckFailures() {
+	return failures;
+}
@@ -0,0 +1,77 @@
+/*
+Options and checks of the simulator scenarios.
+
+A scenario is a named set of options (the command line options override them) and a list of checks.
+Every check prints its result, a failed check makes the simulator exit with status 1,
+so extras/simulator/run_tests.sh and any other script can run the scenarios as regression tests.
+
+The library tests (no sketch) are declared here, each one is in its own file.
+
+=================================================================
+(C) 2026 ifh
+This file is part of PPM to USB Joystick.
+
+PPM to USB Joystick is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+PPM to USB Joystick is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+*/
+
+#ifndef SIMULATOR_SIMTEST_H
+#define SIMULATOR_SIMTEST_H
+
+#include <stdint.h>
+#include "PPMGenerator.h"
+
+//Sets the options: the options of the scenario first, then the command line, a later option wins
+void simSetOptions(const char* scenarioOptions, int argc, char** argv);
+
+//Returns a value of an option --name=value or the default value
+uint32_t simOption(const char* name, uint32_t defaultValue);
+
+//Prints the result of a check, returns the condition. The description is a printf format
+bool simCheck(bool condition, const char* format, ...) __attribute__((format(printf, 2, 3)));
+
+//Returns the number of failed checks
+uint32_t simCheckFailures();
+
+
+//=================Library tests ======================
+//The same generated edges are replayed into a single-edge and a dual-edge (AUTO polarity) PPMReader,
+//the decoded channels are compared with the generated values (CaptureTest.cpp)
+void captureTest(const generatorConfig& config, uint32_t duration);
+
+//A slow ramp of Ch1 with jitter through MedianFilter and ChannelCalibration, the axis from the median
+//and from the fractional output is compared with the ideal axis of the ramp (ResolutionTest.cpp)
+void resolutionTest(const generatorConfig& config, uint32_t duration);
+
+//4 generated streams at different frame rates merged by PPMMerger with 1..4 inputs: merge cost,
+//source of every merged channel, pacing by input 0 and takeover (MergerBenchmark.cpp)
+void mergerBenchmark(const generatorConfig& config, uint32_t duration);
+
+//The report descriptor of JoystickReport with the feature reports of the sketch parsed as a host would:
+//report sizes per ID, axis ranges and the offsets of GetReport() (DescriptorTest.cpp)
+void descriptorTest(const generatorConfig& config, uint32_t duration);
+
+//A generated signal decoded by PPMReader, host time of the edge interrupts and readNormalisedInteger()
+//per frame, with or without RADIO_PROFILE_STATIC (ProfileBenchmark.cpp)
+void profileBenchmark(const generatorConfig& config, uint32_t duration);
+
+//MedianFilter with a time budget window at several frame rates: window size, step delay and a switch
+//to a slower radio (WindowTest.cpp)
+void windowTest(const generatorConfig& config, uint32_t duration);
+
+//The mapping table against the hard-coded mapping it replaced: host time per frame and the same
+//report for the same frames (MapperBenchmark.cpp)
+void mapperBenchmark(const generatorConfig& config, uint32_t duration);
+
+#endif
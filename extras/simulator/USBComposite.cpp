@@ -0,0 +1,111 @@
+/*
+Host stubs of the USB Composite library for the virtual-time simulator.
+
+=================================================================
+(C) 2026 ifh
+This file is part of PPM to USB Joystick.
+
+PPM to USB Joystick is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+PPM to USB Joystick is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+*/
+
+#include "USBComposite.h"
+
+static simReportSink reportSink = NULL;
+static uint32_t enumerationDelay = 150000;
+static bool begun = false;
+static uint32_t beginTime = 0;
+
+USBCompositeDevice USBComposite;
+
+void simSetReportSink(simReportSink sink) {
+	reportSink = sink;
+}
+
+void simSetEnumerationDelay(uint32_t delay) {
+	enumerationDelay = delay;
+}
+
+
+bool USBCompositeDevice::isReady() {
+	return begun && micros() - beginTime >= enumerationDelay;
+}
+
+
+void USBHID::begin(const uint8_t* reportDescriptor, uint16_t length) {
+	descriptor = reportDescriptor;
+	descriptorSize = length;
+	begun = true;
+	beginTime = micros();
+}
+
+void USBHID::setTXInterval(uint8_t interval) {
+	txInterval = interval;
+}
+
+bool USBHID::setFeatureBuffers(HIDBuffer_t* buffers, int count) {
+	featureBuffers = buffers;
+	featureBufferCount = count;
+	return true;
+}
+
+HIDBuffer_t* USBHID::GetFeatureBuffer(uint8_t reportID) {
+	for (int i = 0; i < featureBufferCount; i++) {
+		if (featureBuffers[i].reportID == reportID) {
+			return &featureBuffers[i];
+		}
+	}
+	return NULL;
+}
+
+bool USBHID::simSetFeature(const uint8_t* data, uint16_t size) {
+	HIDBuffer_t* feature = GetFeatureBuffer(data[0]);
+	if (feature == NULL || size > feature->bufferSize) {
+		return false;
+	}
+	memset((uint8_t*)feature->buffer, 0, feature->bufferSize);
+	memcpy((uint8_t*)feature->buffer, data, size);
+	feature->received = true;
+	return true;
+}
+
+
+HIDReporter::HIDReporter(USBHID& HID, uint8_t* buffer, unsigned size, uint8_t reportID) : _HID(HID) {
+	_reportID = reportID;
+	_buffer = buffer;
+	_size = size;
+	if (reportID != 0) {
+		_buffer[0] = reportID;
+	}
+}
+
+void HIDReporter::sendReport() {
+	if (reportSink != NULL) {
+		reportSink(micros(), _buffer, _size);
+	}
+}
+
+uint16_t HIDReporter::getFeature(uint8_t* out, uint8_t poll) {
+	HIDBuffer_t* feature = _HID.GetFeatureBuffer(_reportID);
+	if (feature == NULL || !feature->received) {
+		return 0;
+	}
+	if (poll) {
+		feature->received = false;
+	}
+	if (out != NULL) {
+		memcpy(out, (const uint8_t*)feature->buffer, feature->bufferSize);
+	}
+	return feature->bufferSize;
+}
@@ -0,0 +1,102 @@
+/*
+Host stubs of the USB Composite library for the virtual-time simulator.
+
+HIDReporter::sendReport() passes every report with the simulated time to a report sink.
+Feature buffers are recorded so the simulator can read and write them as the host would.
+USBComposite.isReady() becomes true the enumeration delay after USBHID::begin().
+
+=================================================================
+(C) 2026 ifh
+This file is part of PPM to USB Joystick.
+
+PPM to USB Joystick is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+PPM to USB Joystick is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+*/
+
+#ifndef SIMULATOR_USBCOMPOSITE_H
+#define SIMULATOR_USBCOMPOSITE_H
+
+#include "Arduino.h"
+
+//Receives every report sent, time in microseconds
+typedef void (*simReportSink)(uint32_t time, const uint8_t* report, unsigned size);
+void simSetReportSink(simReportSink sink);
+
+//Time from USBHID::begin() to the end of the enumeration, microseconds
+void simSetEnumerationDelay(uint32_t delay);
+
+
+//Feature report buffers, the buffer includes the report ID
+#define HID_BUFFER_SIZE(n, reportID) ((n) + ((reportID) != 0))
+#define HID_BUFFER_ALLOCATE_SIZE(n, reportID) ((HID_BUFFER_SIZE(n, reportID) + 1) / 2 * 2)
+#define HID_BUFFER_MODE_NO_WAIT 1
+
+class HIDBuffer_t {
+  public:
+    HIDBuffer_t(volatile uint8_t* buffer, uint16_t bufferSize, uint8_t reportID, uint8_t mode = 0)
+        : buffer(buffer), bufferSize(bufferSize), reportID(reportID), mode(mode) {}
+
+    volatile uint8_t* buffer;
+    uint16_t bufferSize;
+    uint8_t reportID;
+    uint8_t mode;
+    bool received = false;  //written by the host, not read yet
+};
+
+
+class USBHID {
+  public:
+    void begin(const uint8_t* reportDescriptor, uint16_t length);
+    void setTXInterval(uint8_t interval);
+    bool setFeatureBuffers(HIDBuffer_t* buffers, int count);
+
+    //Returns the feature buffer of a report ID or NULL, for the simulator
+    HIDBuffer_t* GetFeatureBuffer(uint8_t reportID);
+
+    //A feature report written by the host (SET_REPORT), data includes the report ID, for the simulator
+    bool simSetFeature(const uint8_t* data, uint16_t size);
+
+    //Recorded for the simulator
+    const uint8_t* descriptor = NULL;
+    uint16_t descriptorSize = 0;
+    uint8_t txInterval = 10;
+    HIDBuffer_t* featureBuffers = NULL;
+    int featureBufferCount = 0;
+};
+
+
+class USBCompositeDevice {
+  public:
+    bool isReady();
+};
+
+extern USBCompositeDevice USBComposite;
+
+
+class HIDReporter {
+  public:
+    HIDReporter(USBHID& HID, uint8_t* buffer, unsigned size, uint8_t reportID);
+    void sendReport();
+
+    //Copies a feature report written by the host into out, returns its size or 0 if there is none
+    uint16_t getFeature(uint8_t* out = NULL, uint8_t poll = 1);
+
+  private:
+    USBHID& _HID;
+    uint8_t _reportID;
+    uint8_t* _buffer;
+    unsigned _size;
+};
+
+#endif
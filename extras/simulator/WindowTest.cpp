@@ -0,0 +1,98 @@
+/*
+Filter window test of the virtual-time simulator.
+
+MedianFilter with the window as a time budget (maxWindowTime of the sketch) is fed with frames
+at a fixed interval (no sketch), a step of Ch1 gives the window size and the filter delay per frame rate.
+Then the radio switches from fast frames to frames 4.5 times longer, the frame interval shall be
+measured again and the window shall follow, e.g.
+  ppm_simulator --scenario=window
+
+=================================================================
+(C) 2026 ifh
+This file is part of PPM to USB Joystick.
+
+PPM to USB Joystick is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+PPM to USB Joystick is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+*/
+
+#include <stdio.h>
+
+#include "Arduino.h"
+#include "MedianFilter.h"
+#include "SimTest.h"
+
+#define WINDOW_MAX_WINDOW_TIME 115000
+#define WINDOW_SETTLE_FRAMES 40
+
+//Feeds frames of Ch1 = value, returns the time of the last frame
+static uint32_t windowFeed(MedianFilter& filter, uint32_t time, uint32_t interval, uint32_t frames, uint16_t value, uint16_t* out) {
+	uint16_t in[2] = { 3, value };
+	for (uint32_t k = 0; k < frames; k++) {
+		time += interval;
+		filter.ApplyFilter(in, out, time);
+	}
+	return time;
+}
+
+//Returns the delay of a step of Ch1 after the window has settled at the interval, us
+static uint32_t windowStepDelay(uint32_t interval, uint8_t& windowSize) {
+	MedianFilter filter;
+	filter.channelAmountIn = 1;
+	filter.channelAmountOut = 1;
+	filter.maxWindowTime = WINDOW_MAX_WINDOW_TIME;
+	uint16_t out[2];
+	uint32_t time = windowFeed(filter, 0, interval, WINDOW_SETTLE_FRAMES, 1000, out);
+	windowSize = filter.GetWindowSize();
+	uint32_t frames = 0;
+	do {
+		time = windowFeed(filter, time, interval, 1, 2000, out);
+	} while (out[1] != 2000 && ++frames < MEDIANFILTER_MAX_WINDOW);
+	return frames * interval;
+}
+
+
+void windowTest(const generatorConfig& config, uint32_t duration) {
+	static const uint32_t intervals[] = { 10000, 18000, 22500, 30000, 45000 };
+	(void)config;
+	(void)duration;
+
+	printf("Filter window, time budget %uus:\n", WINDOW_MAX_WINDOW_TIME);
+	for (uint8_t i = 0; i < sizeof(intervals) / sizeof(intervals[0]); i++) {
+		uint8_t windowSize;
+		uint32_t delay = windowStepDelay(intervals[i], windowSize);
+		printf("  frame %6uus: window %u points, step delay %uus\n", intervals[i], windowSize, delay);
+		simCheck(windowSize * intervals[i] <= WINDOW_MAX_WINDOW_TIME && delay == (windowSize - 1) / 2 * intervals[i]
+		         && delay <= WINDOW_MAX_WINDOW_TIME / 2, "frame %uus: window within the budget, delay half of the window",
+		         intervals[i]);
+	}
+
+	//a slower radio after a fast one, every interval is more than 4 frame intervals
+	MedianFilter filter;
+	filter.channelAmountIn = 1;
+	filter.channelAmountOut = 1;
+	filter.maxWindowTime = WINDOW_MAX_WINDOW_TIME;
+	uint16_t out[2];
+	uint32_t time = windowFeed(filter, 0, 10000, WINDOW_SETTLE_FRAMES, 1500, out);
+	uint8_t fastWindow = filter.GetWindowSize();
+	//a single gap is not a new frame rate
+	time = windowFeed(filter, time, 60000, 1, 1500, out);
+	time = windowFeed(filter, time, 10000, 1, 1500, out);
+	uint32_t afterGap = filter.GetFrameInterval();
+	windowFeed(filter, time, 45000, MEDIANFILTER_INTERVAL_RESET_FRAMES + MEDIANFILTER_WINDOW_SETTLE_FRAMES + 8, 1500, out);
+	printf("  10000us -> 45000us frames: window %u -> %u points, frame interval %uus\n", fastWindow,
+	       filter.GetWindowSize(), filter.GetFrameInterval());
+	simCheck(afterGap < 11000, "a single gap does not change the frame interval (%uus)", afterGap);
+	simCheck(filter.GetFrameInterval() > 40000 && filter.GetFrameInterval() < 50000 && filter.GetWindowSize() == 1,
+	         "the frame interval and the window follow a slower radio");
+}
@@ -0,0 +1,56 @@
+#!/bin/sh
+# Builds the simulator variants and runs their scenarios as regression tests.
+# The output of a failed scenario is printed, the exit status is 1 if any check has failed.
+#
+# Usage, from anywhere:  extras/simulator/run_tests.sh
+# The binaries are built in $BUILD_DIR (default /tmp/ppm_simulator_tests).
+#
+# (C) 2026 ifh
+# This file is part of PPM to USB Joystick, see the license in README.md
+
+cd "$(dirname "$0")/../.." || exit 1
+BUILD_DIR=${BUILD_DIR:-/tmp/ppm_simulator_tests}
+mkdir -p "$BUILD_DIR" || exit 1
+failed=0
+
+# build <name> <flags>
+build() {
+	echo "build $1: $2"
+	g++ -std=gnu++11 -O2 -Wall $2 -Iextras/simulator -Isrc extras/simulator/*.cpp src/*.cpp -o "$BUILD_DIR/$1" || failed=1
+}
+
+# run <name> <scenario> ...
+run() {
+	binary=$1
+	shift
+	for scenario in "$@"; do
+		if "$BUILD_DIR/$binary" --scenario="$scenario" > "$BUILD_DIR/$binary.$scenario.log"; then
+			echo "  $binary --scenario=$scenario: ok"
+		else
+			echo "  $binary --scenario=$scenario: FAILED"
+			cat "$BUILD_DIR/$binary.$scenario.log"
+			failed=1
+		fi
+	done
+}
+
+build simulator ""
+run simulator default failsafe dropout signal-loss slow-loop upload capture resolution merger merger-takeover descriptor profile window mapper
+
+build simulator_deferred "-DENABLE_DEFERRED_PROCESSING"
+run simulator_deferred default failsafe dropout signal-loss slow-loop upload
+
+build simulator_output "-DENABLE_PPM_OUTPUT -DENABLE_FRACTIONAL_OUTPUT -DENABLE_STACK_SAMPLES"
+run simulator_output default failsafe signal-loss
+
+build simulator_static "-DRADIO_PROFILE_STATIC"
+run simulator_static default failsafe profile
+
+build simulator_dual "-DENABLE_DUAL_EDGE_CAPTURE -DENABLE_DEFERRED_PROCESSING"
+run simulator_dual default slow-loop
+
+if [ $failed -ne 0 ]; then
+	echo "FAILED"
+	exit 1
+fi
+echo "all scenarios passed"
@@ -0,0 +1,781 @@
+/*
+Deterministic virtual-time simulator of the PPM to USB Joystick firmware.
+
+Runs the real setup() and loop() of the sketch on a PC against a simulated clock.
+A PPM generator drives the sketch's input pin (so PPMReader::ISR is called through
+the attached interrupt exactly as on the board), every HID report sent is recorded
+with its time and a summary is printed at the end of the run:
+ - edge-to-report latency distribution: from the edge which completes a frame to the report carrying it
+ - reports per second, the longest gap between reports
+ - stale reports (no new frame since the previous report) and duplicate reports (same bytes as the previous one)
+ - filter delay: from a step on the stepped channel to the report where its axis passes half of the step
+ - with --upload-at the default mapping table with the stepped channel's axis inverted is uploaded
+   with the mapping feature report as a host would do it, the time it is active from is printed
+ - the signal statistics feature report as a host would read it, the latest report of each group of channels
+ - signal loss: the PPMReader watchdog timer is emulated, its timeout calls PPMReader::onSignalLoss() at the
+   exact time; the number of losses and the detection time come with the diagnostics feature report
+ - pipeline stages: latency from the last edge of a frame to decoded, report ready and report sent, from the
+   diagnostics feature report. With ENABLE_DEFERRED_PROCESSING defined the software interrupt (PendSV) is emulated,
+   it runs right after the edge or watchdog interrupt which requested it, before the clock moves on;
+   compare the stages of both builds with a long --loop-cost
+ - frame queue: frames lost because the PPMReader frame queue was full and the most frames it has held;
+   with a --loop-cost of a few frame periods the frame period of the statistics (the frames the filter and the
+   statistics have seen) stays at the generated one, add -DPPMREADER_FRAME_QUEUE_DEPTH=1 to the build to see it lose frames
+ - the memory monitor feature report: the RAM of the modules as measured on the host
+   (the pointers and the alignment are not those of the STM32, the stack is measured on the board only)
+ - rail reports: reports of a valid frame (not failsafe) with an axis at the end of its range,
+   the generated channels never reach the ends so these are startup or recovery glitches
+ - with ENABLE_PPM_OUTPUT defined (-DENABLE_PPM_OUTPUT) the PPMWriter frame table is played back
+   as the timer and DMA would do it into a second PPMReader and the decoded frames are compared
+   with the frames sent
+
+Each loop() call takes loop-cost microseconds of simulated time, edges which happen
+during a loop() call are handled before the next call with the clock set to the edge time.
+
+Scenarios: --scenario=name runs a named set of options (the command line options override them)
+and checks its results, e.g. one report per frame, the filter delay, signal loss detection;
+every check is printed and the exit status is 1 if a check has failed. A firmware run without
+a scenario has the checks which hold for any signal (no rail reports, PPM output loopback).
+The library tests (no sketch) are scenarios as well, see SimTest.h. --list prints the scenarios,
+extras/simulator/run_tests.sh builds the simulator variants and runs all of them.
+The sketch runs once per process, so a scenario is one run of the simulator.
+
+Build - see the Simulator section of README.md
+
+Usage:
+  ppm_simulator [--scenario=name] [--option=value ...]
+    --list                 list the scenarios and their options
+    --duration=ms          simulated time, default 10000
+    --loop-cost=us         duration of a loop() call, default 2
+    --channels=n           channels in the generated frames, default 8
+    --frame-length=us      default 22500
+    --jitter=us            maximum edge jitter in either direction, default 0
+    --step-channel=n       channel with a periodic step, 0 - none, default 1
+    --step-period=ms       default 500
+    --dropout-period=ms    --dropout-length=ms     signal dropouts, default none
+    --failsafe-period=ms   --failsafe-length=ms    failsafe bursts, default none
+    --spike-frames=n       a noise spike in channel 1 every n frames, default none
+    --seed=n               jitter random seed, default 1
+    --upload-at=ms         upload a mapping table at this time, default none
+    --enumeration=ms       USB enumeration time, default 150
+    --ramp=us              resolution scenario: ramp of this many us over the duration, default 20
+    --policy=n             signal loss policy: 0 - hold, 1 - centre, 2 - throttle cut, default the sketch's
+
+=================================================================
+(C) 2026 ifh
+This file is part of PPM to USB Joystick.
+
+PPM to USB Joystick is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+PPM to USB Joystick is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+*/
+
+#include <stdio.h>
+#include <math.h>
+#include <algorithm>
+#include <vector>
+
+#include "Arduino.h"
+#include "USBComposite.h"
+#include "PPMGenerator.h"
+#include "SimTest.h"
+
+//The sketch itself, compiled as a part of this file so its globals are visible here
+#include "../../PPM_to_USB_Joystick_STM32.ino"
+
+
+typedef struct sentReport {
+    uint32_t time;
+    std::vector<uint8_t> bytes;
+    bool signalLoss;   //sent while the main input is lost, the axes are at the signal loss policy
+} sentReport;
+
+static std::vector<sentReport> reports;
+
+//The latest signal statistics feature report of each group of channels, indexed by its first channel
+static signalStatsReport_t statsReports[SIGNALSTATS_MAX_CHANNELS + 1];
+
+static void readStatsFeature() {
+	HIDBuffer_t* buffer = HID.GetFeatureBuffer(statsReportID);
+	if (buffer == NULL) {
+		return;
+	}
+	signalStatsReport_t report;
+	memcpy(&report, (const uint8_t*)buffer->buffer, sizeof(report));
+	if (report.reportID == statsReportID && report.firstChannel <= SIGNALSTATS_MAX_CHANNELS) {
+		statsReports[report.firstChannel] = report;
+	}
+}
+
+//Returns the diagnostics feature report as a host would read it, NULL if there is none
+static diagnosticsReport_t diagnosticsReport;
+
+static const diagnosticsReport_t* readDiagnosticsFeature() {
+	HIDBuffer_t* buffer = HID.GetFeatureBuffer(diagnosticsReportID);
+	if (buffer == NULL) {
+		return NULL;
+	}
+	memcpy(&diagnosticsReport, (const uint8_t*)buffer->buffer, sizeof(diagnosticsReport));
+	return (diagnosticsReport.reportID == diagnosticsReportID) ? &diagnosticsReport : NULL;
+}
+
+//Signal loss watchdog of the main PPMReader, a timeout before the given time runs the timer interrupt 
+static void watchdogEvents(uint32_t until) {
+	uint32_t deadline = ppm.GetSignalLossDeadline();
+	if (deadline != 0 && deadline < until) {
+		simSetTime(deadline);
+		ppm.onSignalLoss();
+		FrameScheduler::run();
+	}
+}
+
+//Uploads the default mapping table with the axis of a channel inverted, in chunks as a host would do it
+static void uploadMapping(uint8_t invertChannel) {
+	uint8_t size = sizeof(defaultMapping) / sizeof(defaultMapping[0]);
+	mappingUploadReport_t upload;
+	for (uint8_t offset = 0; offset < size; offset += CHANNELMAPPER_UPLOAD_ENTRIES) {
+		memset(&upload, 0, sizeof(upload));
+		upload.reportID = mappingReportID;
+		upload.command = CHANNELMAPPER_COMMAND_WRITE;
+		upload.offset = offset;
+		upload.count = std::min(size - offset, CHANNELMAPPER_UPLOAD_ENTRIES);
+		for (uint8_t k = 0; k < upload.count; k++) {
+			upload.entries[k] = defaultMapping[offset + k];
+			if (upload.entries[k].type == MAPPING_AXIS && upload.entries[k].source == invertChannel) {
+				upload.entries[k].flags |= MAPPING_INVERT;
+			}
+		}
+		HID.simSetFeature((const uint8_t*)&upload, sizeof(upload));
+		loop();  //the sketch takes the report before the host sends the next one
+	}
+	memset(&upload, 0, sizeof(upload));
+	upload.reportID = mappingReportID;
+	upload.command = CHANNELMAPPER_COMMAND_COMMIT;
+	upload.count = size;
+	HID.simSetFeature((const uint8_t*)&upload, sizeof(upload));
+}
+
+//Returns true if the active mapping table has the axis of a channel inverted
+static bool mappingInverted(uint8_t channel) {
+	for (uint8_t i = 0; i < Mapper.GetTableSize(); i++) {
+		const mappingEntry* entry = Mapper.GetEntry(i);
+		if (entry->type == MAPPING_AXIS && entry->source == channel) {
+			return entry->flags & MAPPING_INVERT;
+		}
+	}
+	return false;
+}
+
+//Returns the latest signal statistics report, NULL if there is none
+static const signalStatsReport_t* latestStats() {
+	const signalStatsReport_t* header = NULL;
+	for (uint8_t first = 1; first <= SIGNALSTATS_MAX_CHANNELS; first += SIGNALSTATS_REPORT_CHANNELS) {
+		if (statsReports[first].reportID == statsReportID
+		    && (header == NULL || statsReports[first].frameCount > header->frameCount)) {
+			header = &statsReports[first];
+		}
+	}
+	return header;
+}
+
+static void printStats(const signalStatsReport_t* header) {
+	if (header == NULL) {
+		printf("Signal statistics: no feature report\n");
+		return;
+	}
+	printf("Signal statistics: frames=%u rejected-pulses=%u failsafe-frames=%u frame-period=%uus stddev=%.2fus\n",
+	       header->frameCount, header->rejectedPulses, header->failSafeFrames,
+	       header->framePeriodMean, header->framePeriodStdDev / 16.0);
+	for (uint8_t first = 1; first <= header->channelAmount; first += SIGNALSTATS_REPORT_CHANNELS) {
+		const signalStatsReport_t& report = statsReports[first];
+		for (uint8_t k = 0; k < SIGNALSTATS_REPORT_CHANNELS && first + k <= header->channelAmount; k++) {
+			if (report.reportID != statsReportID) {
+				printf("  Ch%u: no report\n", first + k);
+				continue;
+			}
+			const channelStatsReport_t& channel = report.channels[k];
+			printf("  Ch%u: mean=%.2fus stddev=%.2fus min=%u max=%u outliers=%u\n", first + k,
+			       channel.mean / 16.0, channel.stdDev / 16.0, channel.min, channel.max, channel.outliers);
+		}
+	}
+}
+
+static void printDiagnostics(const diagnosticsReport_t* diagnostics) {
+	if (diagnostics == NULL) {
+		printf("Diagnostics: no feature report\n");
+		return;
+	}
+	printf("Startup: boot to enumeration %ums, boot to the first valid report %ums\n",
+	       diagnostics->enumerationTime, diagnostics->firstReportTime);
+	printf("Signal loss: detected %u times, detection time of the last %uus after the last edge\n",
+	       diagnostics->reader.signalLossCount, diagnostics->reader.signalLossDetectionTime);
+	printf("Frame queue: %u frames lost, at most %u frames queued\n",
+	       diagnostics->reader.frameQueueOverflows, diagnostics->reader.frameQueueHighWater);
+	const frameLatencies& latencies = diagnostics->latencies;
+	printf("Pipeline stages from the last edge: decoded mean=%uus max=%uus, report ready mean=%uus max=%uus, "
+	       "report sent mean=%uus max=%uus\n",
+	       latencies.mean[FRAME_STAGE_DECODED], latencies.max[FRAME_STAGE_DECODED],
+	       latencies.mean[FRAME_STAGE_READY], latencies.max[FRAME_STAGE_READY],
+	       latencies.mean[FRAME_STAGE_SENT], latencies.max[FRAME_STAGE_SENT]);
+}
+
+static void printMemory() {
+	static const char* const moduleNames[MEMORYMONITOR_MODULES] = {
+	    "PPMReader", "MedianFilter", "ChannelCalibration", "ChannelMapper", "SignalStats",
+	    "JoystickReport", "PPMWriter", "PPMMerger", "USB", "sketch"
+	};
+	HIDBuffer_t* buffer = HID.GetFeatureBuffer(memoryReportID);
+	memoryReport_t report;
+	if (buffer == NULL) {
+		printf("Memory: no feature report\n");
+		return;
+	}
+	memcpy(&report, (const uint8_t*)buffer->buffer, sizeof(report));
+	if (report.reportID != memoryReportID) {
+		printf("Memory: no feature report\n");
+		return;
+	}
+	printf("Memory (host sizes):");
+	for (uint8_t i = 0; i < MEMORYMONITOR_MODULES; i++) {
+		printf(" %s=%uB", moduleNames[i], report.moduleSize[i]);
+	}
+	printf("\n");
+}
+
+#ifdef ENABLE_PPM_OUTPUT
+//=======PPM output loopback ==============================================
+//Emulates TIMER3 + DMA of PPMWriter: every update event starts a slot with a separator pulse
+//and takes the next entry of the frame table, the output drives a second PPMReader
+#define LOOPBACK_PIN 40
+
+static PPMReader loopbackReader(channelAmountIn);
+static uint32_t writerNextUpdate = 0;      //time of the next update event
+static uint32_t writerPulseEnd = 0;        //time of the end of the current separator pulse, 0 - none
+static uint8_t writerEntry = 0;            //next table entry
+static uint16_t writerFrame[PPMWRITER_MAX_FRAME_ENTRIES];  //slots of the frame being sent
+static uint32_t loopbackFrames = 0;
+static uint32_t loopbackMismatches = 0;
+static uint32_t loopbackMaxError = 0;
+
+//Returns the time of the next writer event
+static uint32_t writerNextEvent() {
+	return (writerPulseEnd != 0 && writerPulseEnd < writerNextUpdate) ? writerPulseEnd : writerNextUpdate;
+}
+
+static void writerEvent() {
+	uint8_t activeLevel = (PPMout.polarity == INVERTED) ? LOW : HIGH;
+	if (writerPulseEnd != 0 && writerPulseEnd < writerNextUpdate) {
+		simSetTime(writerPulseEnd);
+		simSetPinLevel(LOOPBACK_PIN, 1 - activeLevel);
+		writerPulseEnd = 0;
+		return;
+	}
+
+	//Update event - a separator pulse starts the slot, DMA loads the next entry
+	uint32_t now = writerNextUpdate;
+	uint8_t entries = PPMout.GetFrameEntries();
+	uint8_t slot = writerEntry % entries;
+	uint16_t length = PPMout.GetFrameTable()[writerEntry] + 1;
+	simSetTime(now);
+	simSetPinLevel(LOOPBACK_PIN, activeLevel);
+
+	//The separator which starts the sync slot completes the frame in the reader
+	if (slot == entries - 1 && loopbackFrames++ > 0) {
+		uint16_t decoded[PPMWRITER_MAX_CHANNELS + 1];
+		bool mismatch = false;
+		loopbackReader.readRaw(decoded, true);
+		for (uint8_t i = 1; i < entries; i++) {
+			uint32_t error = abs((int32_t)decoded[i] - (int32_t)writerFrame[i - 1]);
+			loopbackMaxError = std::max(loopbackMaxError, error);
+			mismatch = mismatch || error != 0;
+		}
+		if (mismatch) {
+			++loopbackMismatches;
+		}
+	}
+	writerFrame[slot] = length;
+
+	writerPulseEnd = now + PPMout.separatorLength;
+	writerNextUpdate = now + length;
+	++writerEntry;
+	if (writerEntry == entries) {
+		PPMout.onHalfTransfer();
+	}
+	else if (writerEntry == 2 * entries) {
+		PPMout.onTransferComplete();
+		writerEntry = 0;
+	}
+}
+#endif
+
+static void recordReport(uint32_t time, const uint8_t* report, unsigned size) {
+	sentReport r;
+	r.time = time;
+	r.bytes.assign(report, report + size);
+	r.signalLoss = ppm.IsSignalLost();
+	reports.push_back(r);
+}
+
+
+//Returns a percentile of sorted values
+static uint32_t percentile(const std::vector<uint32_t>& sorted, uint32_t percent) {
+	if (sorted.empty()) {
+		return 0;
+	}
+	size_t index = (sorted.size() - 1) * percent / 100;
+	return sorted[index];
+}
+
+static void printDistribution(const char* name, std::vector<uint32_t> values) {
+	if (values.empty()) {
+		printf("%s: no data\n", name);
+		return;
+	}
+	std::sort(values.begin(), values.end());
+	double sum = 0;
+	for (size_t i = 0; i < values.size(); i++) {
+		sum += values[i];
+	}
+	printf("%s: n=%u min=%u mean=%.1f p50=%u p90=%u p99=%u max=%u\n", name, (unsigned)values.size(),
+	       values.front(), sum / values.size(), percentile(values, 50), percentile(values, 90),
+	       percentile(values, 99), values.back());
+}
+
+//Returns the maximum of values, 0 if there are none
+static uint32_t maximum(const std::vector<uint32_t>& values) {
+	return values.empty() ? 0 : *std::max_element(values.begin(), values.end());
+}
+
+//Returns an axis value from a recorded report
+static uint16_t reportAxis(const sentReport& r, uint8_t axis) {
+	size_t offset = 1 + 2 * axis;
+	if (r.bytes.size() < offset + 2) {
+		return 0;
+	}
+	return r.bytes[offset] | (r.bytes[offset + 1] << 8);
+}
+
+//Returns true if the mapped axes of a report sent during a signal loss are at the value of the policy: 
+//all of them centred, or the axis of the throttle channel at its minimum 
+static bool lossReportAtPolicy(const sentReport& report) {
+	uint16_t centre = ((uint32_t)Calibration.minOutputValue + Calibration.maxOutputValue) / 2;
+	for (uint8_t i = 0; i < sizeof(defaultMapping) / sizeof(defaultMapping[0]); i++) {
+		const mappingEntry& entry = defaultMapping[i];
+		if (entry.type != MAPPING_AXIS || entry.source > channelAmountIn) {
+			continue;
+		}
+		uint16_t value = reportAxis(report, entry.target);
+		if (ppm.signalLossPolicy == FAILSAFE_CENTER && value != centre) {
+			return false;
+		}
+		if (ppm.signalLossPolicy == FAILSAFE_THROTTLE_CUT && entry.source == ppm.throttleChannel
+		    && value != Calibration.minOutputValue) {
+			return false;
+		}
+	}
+	return true;
+}
+
+
+//=======Firmware run ==============================================
+//Results of a run of the sketch
+typedef struct firmwareRun {
+    uint32_t duration = 0;
+    uint32_t loopCost = 0;
+    uint32_t frames = 0;                    //frames generated
+    double reportsPerSecond = 0;
+    uint32_t maxGap = 0;
+    uint32_t staleReports = 0;
+    uint32_t duplicateReports = 0;
+    uint32_t railReports = 0;
+    uint32_t lossReports = 0;               //reports of a signal loss frame
+    uint32_t lossReportsOff = 0;            //of them, with a mapped axis not at the value of the policy
+    std::vector<uint32_t> latencies;        //edge-to-report
+    std::vector<uint32_t> filterDelays;
+    uint32_t uploadAt = 0;                  //0 - no upload
+    uint32_t uploadActive = 0;              //time the uploaded table is active from, 0/1 - not active
+    const signalStatsReport_t* stats = NULL;  //the latest statistics report, NULL - none
+    const diagnosticsReport_t* diagnostics = NULL;  //the latest diagnostics report, NULL - none
+} firmwareRun;
+
+static void runFirmware(const generatorConfig& config, firmwareRun& run) {
+	uint32_t duration = run.duration;
+	uint32_t loopCost = run.loopCost;
+	uint32_t uploadAt = run.uploadAt;
+	uint32_t uploadActive = 0;
+	PPMGenerator generator(config);
+	simSetReportSink(recordReport);
+
+	//Run the firmware
+	simSetTime(0);
+	setup();
+	ppm.signalLossPolicy = (failSafePolicy)simOption("policy", ppm.signalLossPolicy);
+	simSetPinLevel(PPMinputPin, generator.GetIdleLevel());
+#ifdef ENABLE_PPM_OUTPUT
+	pinMode(LOOPBACK_PIN, INPUT_PULLUP);
+	loopbackReader.setupInterrupt(LOOPBACK_PIN, PPMout.polarity);
+	writerNextUpdate = micros() + 1000;
+#endif
+
+	uint32_t now = micros();
+	while (now < duration) {
+		//Interrupts which happened during the previous loop() call
+		while (generator.peekEdge().time <= now) {
+			watchdogEvents(generator.peekEdge().time);
+#ifdef ENABLE_PPM_OUTPUT
+			while (writerNextEvent() < generator.peekEdge().time) {
+				writerEvent();
+			}
+#endif
+			ppmEdge edge = generator.peekEdge();
+			generator.popEdge();
+			simSetTime(edge.time);
+			simSetPinLevel(PPMinputPin, edge.level);
+			FrameScheduler::run();  //the software interrupt requested by the edge interrupt, if any
+		}
+#ifdef ENABLE_PPM_OUTPUT
+		while (writerNextEvent() <= now) {
+			writerEvent();
+		}
+#endif
+		watchdogEvents(now);
+		simSetTime(now);
+		if (uploadAt != 0 && now >= uploadAt && uploadActive == 0) {
+			uploadMapping(config.stepChannel);
+			uploadActive = 1;
+		}
+		loop();
+		readStatsFeature();
+		if (uploadActive == 1 && mappingInverted(config.stepChannel)) {
+			uploadActive = micros();
+		}
+		now += loopCost;
+	}
+	run.uploadActive = uploadActive;
+
+
+	//=======Analyse the run ==============================================
+	//Time when the reader has got each frame - the leading edge which ends its last channel
+	uint8_t readerChannels = (channelAmountIn < config.channelAmount) ? channelAmountIn : config.channelAmount;
+	std::vector<uint32_t> frameTimes;
+	for (size_t k = 0; k < generator.frames.size(); k++) {
+		if (generator.frames[k].edgeTimes[readerChannels] <= duration) {
+			frameTimes.push_back(generator.frames[k].edgeTimes[readerChannels]);
+		}
+	}
+
+	size_t frameIndex = 0;
+	long lastFrame = -1;
+	for (size_t r = 0; r < reports.size(); r++) {
+		while (frameIndex < frameTimes.size() && frameTimes[frameIndex] <= reports[r].time) {
+			++frameIndex;
+		}
+		long frame = (long)frameIndex - 1;
+		if (frame < 0 || frame == lastFrame) {
+			++run.staleReports;
+		}
+		else
+		{
+			run.latencies.push_back(reports[r].time - frameTimes[frame]);
+			lastFrame = frame;
+		}
+		if (reports[r].signalLoss) {
+			++run.lossReports;
+			if (!lossReportAtPolicy(reports[r])) {
+				++run.lossReportsOff;
+			}
+		}
+		else if (frame >= 0 && !generator.frames[frame].failsafe
+		         && (frame == 0 || !generator.frames[frame - 1].failsafe)) {  //the frame a failsafe ends on may be read as failsafe
+			for (uint8_t i = 0; i < sizeof(defaultMapping) / sizeof(defaultMapping[0]); i++) {
+				if (defaultMapping[i].type == MAPPING_AXIS && defaultMapping[i].source <= readerChannels) {
+					uint16_t value = reportAxis(reports[r], defaultMapping[i].target);
+					if (value == JOYSTICKREPORT_AXIS_MIN || value == JOYSTICKREPORT_AXIS_MAX) {
+						++run.railReports;
+						break;
+					}
+				}
+			}
+		}
+		if (r > 0) {
+			if (reports[r].bytes == reports[r - 1].bytes) {
+				++run.duplicateReports;
+			}
+			run.maxGap = std::max(run.maxGap, reports[r].time - reports[r - 1].time);
+		}
+	}
+
+	//Filter delay, from the frame with a step to the report where the axis passes half of the step
+	int axis = -1;
+	for (uint8_t i = 0; i < sizeof(defaultMapping) / sizeof(defaultMapping[0]); i++) {
+		if (config.stepChannel != 0 && defaultMapping[i].type == MAPPING_AXIS && defaultMapping[i].source == config.stepChannel) {
+			axis = defaultMapping[i].target;
+			break;
+		}
+	}
+	if (axis >= 0 && config.stepChannel <= readerChannels) {
+		size_t r = 0;
+		for (size_t k = 1; k < generator.frames.size(); k++) {
+			const generatedFrame& previous = generator.frames[k - 1];
+			const generatedFrame& frame = generator.frames[k];
+			if (frame.failsafe || previous.failsafe
+			    || frame.values[config.stepChannel] == previous.values[config.stepChannel]) {
+				continue;
+			}
+			uint32_t stepTime = frame.edgeTimes[readerChannels];
+			uint16_t from = Calibration.map(config.stepChannel, previous.values[config.stepChannel]);
+			uint16_t to = Calibration.map(config.stepChannel, frame.values[config.stepChannel]);
+			//with an uploaded table the axis is inverted from the time the table is active
+			if (uploadAt != 0 && stepTime >= uploadAt) {
+				if (uploadActive <= 1 || stepTime < uploadActive) {
+					continue;
+				}
+				from = JOYSTICKREPORT_AXIS_MAX + JOYSTICKREPORT_AXIS_MIN - from;
+				to = JOYSTICKREPORT_AXIS_MAX + JOYSTICKREPORT_AXIS_MIN - to;
+			}
+			uint16_t half = (from + to) / 2;
+			while (r < reports.size() && reports[r].time < stepTime) {
+				++r;
+			}
+			for (size_t q = r; q < reports.size(); q++) {
+				uint16_t value = reportAxis(reports[q], axis);
+				if ((to > from && value >= half) || (to < from && value <= half)) {
+					run.filterDelays.push_back(reports[q].time - stepTime);
+					break;
+				}
+			}
+		}
+	}
+
+	run.frames = generator.frames.size();
+	run.reportsPerSecond = reports.size() * 1000000.0 / duration;
+	run.stats = latestStats();
+	run.diagnostics = readDiagnosticsFeature();
+
+	printf("Frames generated: %u\n", run.frames);
+	printf("Reports sent: %u, %.1f per second, longest gap %uus\n", (unsigned)reports.size(), run.reportsPerSecond, run.maxGap);
+	printf("Stale reports: %u, duplicate reports: %u, rail reports: %u\n", run.staleReports, run.duplicateReports, run.railReports);
+	printf("Signal loss reports: %u, %u not at the policy %u\n", run.lossReports, run.lossReportsOff, ppm.signalLossPolicy);
+	printDistribution("Edge-to-report latency, us", run.latencies);
+	printDistribution("Filter delay, us", run.filterDelays);
+	if (uploadAt != 0) {
+		if (uploadActive > 1) {
+			printf("Mapping upload at %ums: active from %uus, %u entries, upload errors %u\n", uploadAt / 1000,
+			       uploadActive, Mapper.GetTableSize(), Mapper.GetUploadErrors());
+		}
+		else
+		{
+			printf("Mapping upload at %ums: not active, upload errors %u\n", uploadAt / 1000, Mapper.GetUploadErrors());
+		}
+	}
+	printStats(run.stats);
+	printDiagnostics(run.diagnostics);
+	printMemory();
+#ifdef ENABLE_PPM_OUTPUT
+	printf("PPM output loopback: %u frames, %u mismatched, max error %uus\n",
+	       loopbackFrames > 0 ? loopbackFrames - 1 : 0, loopbackMismatches, loopbackMaxError);
+#endif
+}
+
+
+//=======Scenarios ==============================================
+//Checks of every firmware run
+static void checkFirmware(const generatorConfig& config, const firmwareRun& run) {
+	(void)config;
+	simCheck(run.stats != NULL, "the signal statistics feature report is read");
+	simCheck(run.diagnostics != NULL, "the diagnostics feature report is read");
+	simCheck(run.railReports == 0, "no report of a valid frame with an axis at the end of its range");
+	if (run.uploadAt != 0) {
+		simCheck(run.uploadActive > 1 && Mapper.GetUploadErrors() == 0, "the uploaded mapping table is active");
+	}
+#ifdef ENABLE_PPM_OUTPUT
+	simCheck(loopbackFrames > 1 && loopbackMismatches == 0, "PPM output loopback: %u mismatched frames", loopbackMismatches);
+#endif
+}
+
+//The frame period seen by the statistics is the generated one, so every frame has reached the filter and the statistics
+static void checkEveryFrame(const generatorConfig& config, const firmwareRun& run) {
+	if (run.stats == NULL) {
+		return;
+	}
+	simCheck(abs((int32_t)run.stats->framePeriodMean - (int32_t)config.frameLength) <= 100,
+	         "statistics frame period %uus is the generated %uus", run.stats->framePeriodMean, config.frameLength);
+	if (run.diagnostics != NULL) {
+		simCheck(run.diagnostics->reader.frameQueueOverflows == 0, "no frames lost in the frame queue");
+	}
+}
+
+static void checkDefault(const generatorConfig& config, const firmwareRun& run) {
+	simCheck(run.reportsPerSecond >= 0.99e6 / config.frameLength, "%.1f reports per second, one per frame", run.reportsPerSecond);
+	simCheck(run.staleReports == 0, "no stale reports");
+	simCheck(percentile(run.latencies, 99) <= 1000 + run.loopCost, "edge-to-report latency p99 %uus <= 1ms USB interval + loop()",
+	         percentile(run.latencies, 99));
+	//5 point median: the step passes the middle of the window after 2 frames
+	simCheck(!run.filterDelays.empty() && maximum(run.filterDelays) <= 2 * config.frameLength + 1000,
+	         "filter delay max %uus <= 2 frames", maximum(run.filterDelays));
+	checkEveryFrame(config, run);
+	if (run.diagnostics != NULL) {
+		simCheck(run.diagnostics->reader.signalLossCount == 0, "no signal loss detected");
+	}
+	//the steps of a channel are stick movement, not outliers (the jitter is below the threshold)
+	if (config.stepChannel != 0 && 4 * config.jitter <= Stats.outlierThreshold) {
+		uint8_t first = (config.stepChannel - 1) / SIGNALSTATS_REPORT_CHANNELS * SIGNALSTATS_REPORT_CHANNELS + 1;
+		const signalStatsReport_t& report = statsReports[first];
+		simCheck(report.reportID == statsReportID && report.channels[config.stepChannel - first].outliers == 0,
+		         "no outliers on the stepped channel Ch%u", config.stepChannel);
+	}
+}
+
+static void checkFailsafe(const generatorConfig& config, const firmwareRun& run) {
+	simCheck(maximum(run.filterDelays) <= 2 * config.frameLength + 2 * config.jitter + 1000,
+	         "filter delay max %uus <= 2 frames", maximum(run.filterDelays));
+	if (run.stats != NULL) {
+		simCheck(run.stats->failSafeFrames > 0, "failsafe frames counted: %u", run.stats->failSafeFrames);
+	}
+	if (run.diagnostics != NULL) {
+		simCheck(run.diagnostics->reader.signalLossCount == 0, "a failsafe burst is not a signal loss");
+	}
+}
+
+static void checkDropout(const generatorConfig& config, const firmwareRun& run) {
+	uint32_t dropouts = (run.duration - config.frameLength) / config.dropoutPeriod;
+	if (run.diagnostics != NULL) {
+		const ppmDiagnostics& reader = run.diagnostics->reader;
+		simCheck(reader.signalLossCount == dropouts, "signal loss detected %u times for %u dropouts",
+		         reader.signalLossCount, dropouts);
+		simCheck(reader.signalLossDetectionTime <= config.frameLength + 1000, "signal loss detected %uus after the last edge",
+		         reader.signalLossDetectionTime);
+	}
+}
+
+static void checkSignalLoss(const generatorConfig& config, const firmwareRun& run) {
+	checkDropout(config, run);
+	simCheck(run.lossReports > 0 && run.lossReportsOff == 0, "%u of %u signal loss reports at the policy %u",
+	         run.lossReports - run.lossReportsOff, run.lossReports, ppm.signalLossPolicy);
+}
+
+static void checkSlowLoop(const generatorConfig& config, const firmwareRun& run) {
+	simCheck(run.reportsPerSecond >= 0.95e6 / std::max(run.loopCost, config.frameLength), "%.1f reports per second, one per loop()",
+	         run.reportsPerSecond);
+	checkEveryFrame(config, run);
+#ifdef ENABLE_DEFERRED_PROCESSING
+	if (run.diagnostics != NULL) {
+		simCheck(run.diagnostics->latencies.max[FRAME_STAGE_READY] <= 1000,
+		         "the report is ready %uus after the last edge, loop() does not delay it",
+		         run.diagnostics->latencies.max[FRAME_STAGE_READY]);
+	}
+#endif
+}
+
+static void checkUpload(const generatorConfig& config, const firmwareRun& run) {
+	(void)config;
+	simCheck(run.uploadActive > 1 && run.uploadActive - run.uploadAt <= 100000, "the table is active within 100ms of the upload");
+	simCheck(!run.filterDelays.empty(), "the inverted axis follows the steps after the upload");
+}
+
+typedef struct simScenario {
+    const char* name;
+    const char* options;   //options of the scenario, the command line options override them
+    void (*test)(const generatorConfig& config, uint32_t duration);      //a library test, NULL - run the firmware
+    void (*check)(const generatorConfig& config, const firmwareRun& run);  //checks of the firmware run, with checkFirmware()
+} simScenario;
+
+static const simScenario scenarios[] = {
+    {"default", "", NULL, checkDefault},
+    {"failsafe", "--jitter=20 --failsafe-period=4000 --failsafe-length=300", NULL, checkFailsafe},
+    {"dropout", "--dropout-period=3000 --dropout-length=300", NULL, checkDropout},
+    {"signal-loss", "--dropout-period=3000 --dropout-length=300 --policy=1", NULL, checkSignalLoss},
+    {"slow-loop", "--loop-cost=50000 --jitter=3", NULL, checkSlowLoop},
+    {"upload", "--upload-at=2000", NULL, checkUpload},
+    {"capture", "--jitter=10 --spike-frames=5", captureTest, NULL},
+    {"resolution", "--ramp=20 --jitter=1", resolutionTest, NULL},
+    {"merger", "--loop-cost=100 --jitter=5", mergerBenchmark, NULL},
+    {"merger-takeover", "--loop-cost=100 --dropout-period=3000 --dropout-length=300", mergerBenchmark, NULL},
+    {"descriptor", "", descriptorTest, NULL},
+    {"profile", "--duration=60000", profileBenchmark, NULL},
+    {"window", "", windowTest, NULL},
+    {"mapper", "--duration=200000", mapperBenchmark, NULL}
+};
+#define SCENARIO_AMOUNT (sizeof(scenarios) / sizeof(scenarios[0]))
+
+
+int main(int argc, char** argv) {
+	const simScenario* scenario = NULL;
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--list") == 0) {
+			for (size_t k = 0; k < SCENARIO_AMOUNT; k++) {
+				printf("%-12s %s\n", scenarios[k].name, scenarios[k].options);
+			}
+			return 0;
+		}
+		if (strncmp(argv[i], "--scenario=", 11) == 0) {
+			for (size_t k = 0; k < SCENARIO_AMOUNT; k++) {
+				if (strcmp(argv[i] + 11, scenarios[k].name) == 0) {
+					scenario = &scenarios[k];
+				}
+			}
+			if (scenario == NULL) {
+				printf("Unknown scenario %s, see --list\n", argv[i] + 11);
+				return 2;
+			}
+		}
+	}
+	simSetOptions(scenario != NULL ? scenario->options : "", argc, argv);
+
+	generatorConfig config;
+	uint32_t duration = simOption("duration", 10000) * 1000;
+	uint32_t loopCost = simOption("loop-cost", 2);
+	config.channelAmount = simOption("channels", config.channelAmount);
+	config.frameLength = simOption("frame-length", config.frameLength);
+	config.jitter = simOption("jitter", config.jitter);
+	config.stepChannel = simOption("step-channel", config.stepChannel);
+	config.stepPeriod = simOption("step-period", config.stepPeriod / 1000) * 1000;
+	config.dropoutPeriod = simOption("dropout-period", 0) * 1000;
+	config.dropoutLength = simOption("dropout-length", 0) * 1000;
+	config.failsafePeriod = simOption("failsafe-period", 0) * 1000;
+	config.failsafeLength = simOption("failsafe-length", 0) * 1000;
+	config.spikeFrames = simOption("spike-frames", 0);
+	config.seed = simOption("seed", config.seed);
+	simSetEnumerationDelay(simOption("enumeration", 150) * 1000);
+	if (loopCost == 0) {
+		loopCost = 1;
+	}
+
+	printf("Scenario: %s duration=%ums loop-cost=%uus channels=%u frame-length=%uus jitter=%uus step-channel=%u "
+	       "dropout=%u/%ums failsafe=%u/%ums seed=%u\n", scenario != NULL ? scenario->name : "-",
+	       duration / 1000, loopCost, config.channelAmount, config.frameLength, config.jitter, config.stepChannel,
+	       config.dropoutLength / 1000, config.dropoutPeriod / 1000,
+	       config.failsafeLength / 1000, config.failsafePeriod / 1000, config.seed);
+
+	if (scenario != NULL && scenario->test != NULL) {
+		scenario->test(config, duration);
+	}
+	else
+	{
+		firmwareRun run;
+		run.duration = duration;
+		run.loopCost = loopCost;
+		run.uploadAt = simOption("upload-at", 0) * 1000;
+		runFirmware(config, run);
+		checkFirmware(config, run);
+		if (scenario != NULL && scenario->check != NULL) {
+			scenario->check(config, run);
+		}
+	}
+
+	if (simCheckFailures() > 0) {
+		printf("%u checks FAILED\n", simCheckFailures());
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,161 @@
+#!/usr/bin/env python3
+"""
+RAM and flash per module from the GNU linker map of the firmware.
+
+The modules are the object files of the sketch and src/ (PPMReader, MedianFilter, ...),
+the libraries (USBComposite, EEPROM, ...), the core (libmaple) and the C/C++ runtime.
+Flash is .text, .rodata, the other read only sections and the initial values of .data;
+RAM is .data and .bss. The rest of the RAM is left for the heap and the stack,
+compare it with the stack high-water mark of the memory monitor feature report (src/MemoryMonitor.h).
+
+Usage:
+  python3 extras/tools/memory_map.py <build folder>/PPM_to_USB_Joystick_STM32.ino.map [--ram=20480] [--flash=110592]
+
+The Arduino IDE writes the map into the build folder (shown with the verbose compile output);
+the defaults are the Maple Mini RAM and the flash above the 20K bootloader.
+
+=================================================================
+(C) 2026 ifh
+This file is part of PPM to USB Joystick.
+
+PPM to USB Joystick is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+PPM to USB Joystick is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+"""
+
+import argparse
+import os
+import re
+import sys
+
+#Output sections, by the start of their name
+FLASH_SECTIONS = ('.text', '.rodata', '.ARM.ex', '.init_array', '.fini_array', '.preinit_array',
+                  '.eh_frame', '.gcc_except_table', '.isr_vector')
+DATA_SECTIONS = ('.data',)
+BSS_SECTIONS = ('.bss', '.noinit', 'COMMON')
+
+RUNTIME_LIBRARIES = ('libc', 'libg', 'libm', 'libgcc', 'libstdc++', 'libsupc++', 'libnosys', 'crt')
+
+#An input section on one line, or the address/size/file line after a long section name
+INPUT_SECTION = re.compile(r'^ (\.\S+|COMMON)\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(\S.*)$')
+INPUT_SECTION_NAME = re.compile(r'^ (\.\S+|COMMON)\s*$')
+INPUT_SECTION_REST = re.compile(r'^\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(\S.*)$')
+OUTPUT_SECTION = re.compile(r'^(\.\S+)')
+
+
+def module_name(path):
+    """Returns the module of an object file or an archive member"""
+    path = path.strip().replace('\\', '/')
+    archive = re.match(r'^(.*?)\((.*)\)$', path)
+    member = path
+    if archive:
+        path, member = archive.group(1), archive.group(2)
+    base = os.path.basename(path)
+
+    if base.startswith(RUNTIME_LIBRARIES):
+        return 'C/C++ runtime'
+    library = re.search(r'/libraries/([^/]+)/', path)
+    if library:
+        return library.group(1)
+    if '/cores/' in path or base == 'core.a' or 'libmaple' in path:
+        return 'core (libmaple)'
+    if archive:
+        return os.path.basename(member)
+    if '.ino.' in base:
+        return 'sketch'
+    return re.sub(r'(\.(cpp|c|S))?\.o$', '', base)
+
+
+def section_kind(output_section):
+    if output_section.startswith(DATA_SECTIONS):
+        return 'data'
+    if output_section.startswith(BSS_SECTIONS):
+        return 'bss'
+    if output_section.startswith(FLASH_SECTIONS):
+        return 'flash'
+    return None
+
+
+def parse(lines):
+    """Returns {module: {'flash': bytes, 'data': bytes, 'bss': bytes}}"""
+    modules = {}
+    in_map = False
+    output_section = None
+    pending_name = None
+
+    for line in lines:
+        line = line.rstrip('\n')
+        if not in_map:
+            in_map = line.startswith('Linker script and memory map')
+            continue
+
+        output = OUTPUT_SECTION.match(line)
+        if output:
+            output_section = output.group(1)
+            pending_name = None
+            continue
+
+        match = INPUT_SECTION.match(line)
+        if match:
+            name, size, path = match.group(1), int(match.group(3), 16), match.group(4)
+        elif pending_name:
+            rest = INPUT_SECTION_REST.match(line)
+            pending = pending_name
+            pending_name = None
+            if not rest:
+                continue
+            name, size, path = pending, int(rest.group(2), 16), rest.group(3)
+        else:
+            named = INPUT_SECTION_NAME.match(line)
+            if named:
+                pending_name = named.group(1)
+            continue
+
+        kind = section_kind(output_section or name)
+        if kind is None or size == 0:
+            continue
+        if name == 'COMMON':
+            kind = 'bss'
+        entry = modules.setdefault(module_name(path), {'flash': 0, 'data': 0, 'bss': 0})
+        entry[kind] += size
+
+    return modules
+
+
+def main():
+    parser = argparse.ArgumentParser(description='RAM and flash per module from a GNU linker map')
+    parser.add_argument('map', help='linker map file')
+    parser.add_argument('--ram', type=int, default=20480, help='RAM size, bytes')
+    parser.add_argument('--flash', type=int, default=110592, help='flash size available to the sketch, bytes')
+    args = parser.parse_args()
+
+    with open(args.map, errors='replace') as f:
+        modules = parse(f)
+    if not modules:
+        sys.exit('No input sections found, is it a GNU linker map?')
+
+    print('%-24s %8s %8s %8s' % ('module', 'flash', 'data', 'bss'))
+    total = {'flash': 0, 'data': 0, 'bss': 0}
+    for name, entry in sorted(modules.items(), key=lambda m: (-(m[1]['data'] + m[1]['bss']), -m[1]['flash'])):
+        print('%-24s %8d %8d %8d' % (name, entry['flash'] + entry['data'], entry['data'], entry['bss']))
+        for kind in total:
+            total[kind] += entry[kind]
+
+    flash = total['flash'] + total['data']
+    ram = total['data'] + total['bss']
+    print('%-24s %8d %8d %8d' % ('total', flash, total['data'], total['bss']))
+    print('Flash: %d of %d bytes (%.1f%%)' % (flash, args.flash, 100.0 * flash / args.flash))
+    print('RAM: %d of %d bytes static, %d bytes left for the heap and the stack' % (ram, args.ram, args.ram - ram))
+
+
+if __name__ == '__main__':
+    main()
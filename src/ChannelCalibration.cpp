@@ -0,0 +1,338 @@
+/*
+Channel calibration
+
+Per channel endpoints and centre, tracked while calibrating, and the integer mapping to the output range.
+
+Flash storage uses the EEPROM emulation library of Arduino_STM32 (two 1K pages at the end of the flash).
+
+TODO - see the .h file
+=================================================================
+(C) 2026 ifh
+This file is part of PPM to USB Joystick.
+
+PPM to USB Joystick is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+PPM to USB Joystick is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+*/
+
+// Set to true to print some debug messages, or false to disable them.
+//#define ENABLE_DEBUG_OUTPUT_CHANNELCALIBRATION
+
+#include "Arduino.h"
+#include "ChannelCalibration.h"
+
+#ifdef __STM32F1__
+#include <EEPROM.h>
+#endif
+
+
+/* Set ChannelCalibration object */
+ChannelCalibration::ChannelCalibration() {
+	for (uint8_t i=0; i<=CHANNELCALIBRATION_MAX_CHANNELS; i++) {
+		setCoefficients(&_coefficients[0][i], activeRadio.minNormalChannelValue,
+		                activeRadio.channelMidPoint, activeRadio.maxNormalChannelValue);
+		_coefficients[1][i] = _coefficients[0][i];
+	}
+	_active = 0;
+}
+
+
+/* Delete ChannelCalibration object */
+ChannelCalibration::~ChannelCalibration() {
+}
+
+
+/* Function to calculate the coefficients of a channel, min < centre < max */
+void ChannelCalibration::setCoefficients(channelCoefficients* coefficients, uint16_t min, uint16_t centre, uint16_t max) {
+	uint16_t outputMidPoint = ((uint32_t)minOutputValue + maxOutputValue) / 2;
+	uint32_t low = centre - min;
+	uint32_t high = max - centre;
+
+	coefficients->min = min;
+	coefficients->centre = centre;
+	coefficients->max = max;
+	//rounded up, so min and max give exactly the ends of the output range
+	coefficients->lowScale = (((uint32_t)(outputMidPoint - minOutputValue) << 16) + low - 1) / low;
+	coefficients->highScale = (((uint32_t)(maxOutputValue - outputMidPoint) << 16) + high - 1) / high;
+}
+
+
+/* Function to map a channel value to the output range */
+uint16_t ChannelCalibration::map(uint8_t channel, uint16_t value) {
+	return mapQ4(channel, (uint32_t)value << 4);
+}
+
+
+/* Function to map a channel value in 1/16 us to the output range.
+The scales are Q16 per us, so the product of a Q4 offset is Q20, it needs 64 bits (one UMULL) */
+uint16_t ChannelCalibration::mapQ4(uint8_t channel, uint32_t valueQ4) {
+	uint16_t outputMidPoint = ((uint32_t)minOutputValue + maxOutputValue) / 2;
+	if (channel == 0 || channel > CHANNELCALIBRATION_MAX_CHANNELS) {
+		return outputMidPoint;
+	}
+
+	const channelCoefficients* coefficients = &_coefficients[_active][channel];
+	uint32_t min = (uint32_t)coefficients->min << 4;
+	uint32_t centre = (uint32_t)coefficients->centre << 4;
+	uint32_t max = (uint32_t)coefficients->max << 4;
+	if (valueQ4 <= min) {
+		return minOutputValue;
+	}
+	if (valueQ4 >= max) {
+		return maxOutputValue;
+	}
+	if (valueQ4 < centre) {
+		uint32_t offset = ((uint64_t)(centre - valueQ4) * coefficients->lowScale) >> 20;
+		return (offset < (uint32_t)(outputMidPoint - minOutputValue)) ? outputMidPoint - offset : minOutputValue;
+	}
+	uint32_t offset = ((uint64_t)(valueQ4 - centre) * coefficients->highScale) >> 20;
+	return (offset < (uint32_t)(maxOutputValue - outputMidPoint)) ? outputMidPoint + offset : maxOutputValue;
+}
+
+
+/* Functions to return the calibrated min/centre/max of a channel */
+uint16_t ChannelCalibration::GetMin(uint8_t channel) {
+	return (channel <= CHANNELCALIBRATION_MAX_CHANNELS) ? _coefficients[_active][channel].min : 0;
+}
+
+uint16_t ChannelCalibration::GetCentre(uint8_t channel) {
+	return (channel <= CHANNELCALIBRATION_MAX_CHANNELS) ? _coefficients[_active][channel].centre : 0;
+}
+
+uint16_t ChannelCalibration::GetMax(uint8_t channel) {
+	return (channel <= CHANNELCALIBRATION_MAX_CHANNELS) ? _coefficients[_active][channel].max : 0;
+}
+
+
+/* Function to start the calibration mode */
+void ChannelCalibration::begin() {
+	for (uint8_t i=0; i<=CHANNELCALIBRATION_MAX_CHANNELS; i++) {
+		_min[i] = 0xFFFF;
+		_max[i] = 0;
+		_centre[i] = 0;
+		_pendingMinFrames[i] = 0;
+		_pendingMaxFrames[i] = 0;
+		_lastValue[i] = 0;
+		_restFrames[i] = 0;
+	}
+	_calibrating = true;
+
+#ifdef ENABLE_DEBUG_OUTPUT_CHANNELCALIBRATION
+  Serial.println("ChannelCalibration::begin completed");
+#endif
+}
+
+
+/* Function to return true in the calibration mode */
+bool ChannelCalibration::isCalibrating() {
+	return _calibrating;
+}
+
+
+/* Function to update the observed ranges with a frame */
+void ChannelCalibration::update(const uint16_t* channels) {
+	if (!_calibrating || channels[0] == codeFailSafe) {
+		return;
+	}
+
+	bool changed = false;
+	for (uint8_t i=1; i<=channelAmount; i++) {
+		uint16_t value = channels[i];
+
+		//Extremes, confirmed by confirmFrames frames in a row
+		if (value < _min[i]) {
+			if (_pendingMinFrames[i] == 0 || value > _pendingMin[i]) {
+				_pendingMin[i] = value;
+			}
+			if (++_pendingMinFrames[i] >= confirmFrames) {
+				_min[i] = _pendingMin[i];
+				_pendingMinFrames[i] = 0;
+				changed = true;
+			}
+		}
+		else
+		{
+			_pendingMinFrames[i] = 0;
+		}
+		if (value > _max[i]) {
+			if (_pendingMaxFrames[i] == 0 || value < _pendingMax[i]) {
+				_pendingMax[i] = value;
+			}
+			if (++_pendingMaxFrames[i] >= confirmFrames) {
+				_max[i] = _pendingMax[i];
+				_pendingMaxFrames[i] = 0;
+				changed = true;
+			}
+		}
+		else
+		{
+			_pendingMaxFrames[i] = 0;
+		}
+
+		//Centre, averaged while the stick rests in the middle half of the range
+		uint16_t step = (value > _lastValue[i]) ? value - _lastValue[i] : _lastValue[i] - value;
+		_lastValue[i] = value;
+		if (step > restTolerance) {
+			_restFrames[i] = 0;
+			continue;
+		}
+		if (_restFrames[i] < restFrames) {
+			++_restFrames[i];
+			continue;
+		}
+		if (_max[i] <= _min[i] || _max[i] - _min[i] < minSpan) {
+			continue;
+		}
+		uint16_t quarter = (_max[i] - _min[i]) / 4;
+		if (value > _min[i] + quarter && value < _max[i] - quarter) {
+			uint32_t previous = _centre[i] >> 4;
+			if (_centre[i] == 0) {
+				_centre[i] = (uint32_t)value << 4;
+			}
+			else
+			{
+				_centre[i] = (int32_t)_centre[i] + (((int32_t)value << 4) - (int32_t)_centre[i]) / 8;
+			}
+			if ((_centre[i] >> 4) != previous) {
+				changed = true;
+			}
+		}
+	}
+
+	if (changed) {
+		commit();
+	}
+}
+
+
+/* Function to end the calibration mode and save the calibration */
+bool ChannelCalibration::end() {
+	if (!_calibrating) {
+		return false;
+	}
+	commit();
+	_calibrating = false;
+	return save();
+}
+
+
+/* Function to calculate a new set of coefficients from the observed values and make it active.
+Channels without a valid range keep their current values */
+void ChannelCalibration::commit() {
+	uint16_t min[CHANNELCALIBRATION_MAX_CHANNELS + 1];
+	uint16_t centre[CHANNELCALIBRATION_MAX_CHANNELS + 1];
+	uint16_t max[CHANNELCALIBRATION_MAX_CHANNELS + 1];
+
+	for (uint8_t i=0; i<=CHANNELCALIBRATION_MAX_CHANNELS; i++) {
+		const channelCoefficients* current = &_coefficients[_active][i];
+		min[i] = current->min;
+		centre[i] = current->centre;
+		max[i] = current->max;
+		if (i == 0 || i > channelAmount || _max[i] <= _min[i] || _max[i] - _min[i] < minSpan) {
+			continue;
+		}
+		min[i] = _min[i];
+		max[i] = _max[i];
+		centre[i] = (_centre[i] + 8) >> 4;
+		if (centre[i] <= min[i] || centre[i] >= max[i]) {
+			centre[i] = ((uint32_t)min[i] + max[i]) / 2;  //not detected (e.g. throttle)
+		}
+	}
+	commit(min, centre, max);
+}
+
+
+/* Function to calculate a new set of coefficients into the inactive buffer and make it active */
+void ChannelCalibration::commit(const uint16_t* min, const uint16_t* centre, const uint16_t* max) {
+	uint8_t next = _active ^ 1;
+	for (uint8_t i=0; i<=CHANNELCALIBRATION_MAX_CHANNELS; i++) {
+		setCoefficients(&_coefficients[next][i], min[i], centre[i], max[i]);
+	}
+	_active = next;
+}
+
+
+/* Function to load the calibration from the flash */
+bool ChannelCalibration::load() {
+#ifdef __STM32F1__
+	uint16_t address = CHANNELCALIBRATION_EEPROM_ADDRESS;
+	uint16_t data = 0;
+	uint16_t min[CHANNELCALIBRATION_MAX_CHANNELS + 1];
+	uint16_t centre[CHANNELCALIBRATION_MAX_CHANNELS + 1];
+	uint16_t max[CHANNELCALIBRATION_MAX_CHANNELS + 1];
+
+	EEPROM.init();
+	if (EEPROM.read(address++, &data) != EEPROM_OK || data != CHANNELCALIBRATION_EEPROM_MARKER) {
+		return false;
+	}
+	uint16_t checksum = data;
+	min[0] = _coefficients[_active][0].min;
+	centre[0] = _coefficients[_active][0].centre;
+	max[0] = _coefficients[_active][0].max;
+	for (uint8_t i=1; i<=CHANNELCALIBRATION_MAX_CHANNELS; i++) {
+		if (EEPROM.read(address++, &min[i]) != EEPROM_OK
+		    || EEPROM.read(address++, &centre[i]) != EEPROM_OK
+		    || EEPROM.read(address++, &max[i]) != EEPROM_OK) {
+			return false;
+		}
+		if (!(min[i] < centre[i] && centre[i] < max[i])) {
+			return false;
+		}
+		checksum += min[i] + centre[i] + max[i];
+	}
+	if (EEPROM.read(address, &data) != EEPROM_OK || data != checksum) {
+		return false;
+	}
+	commit(min, centre, max);
+
+  #ifdef ENABLE_DEBUG_OUTPUT_CHANNELCALIBRATION
+  Serial.println("ChannelCalibration::load completed");
+  #endif
+	return true;
+#else
+	return false;
+#endif
+}
+
+
+/* Function to save the calibration to the flash */
+bool ChannelCalibration::save() {
+#ifdef __STM32F1__
+	uint16_t address = CHANNELCALIBRATION_EEPROM_ADDRESS;
+	uint16_t checksum = CHANNELCALIBRATION_EEPROM_MARKER;
+	const channelCoefficients* coefficients = _coefficients[_active];
+
+	EEPROM.init();
+	if (EEPROM.update(address++, CHANNELCALIBRATION_EEPROM_MARKER) != EEPROM_OK) {
+		return false;
+	}
+	for (uint8_t i=1; i<=CHANNELCALIBRATION_MAX_CHANNELS; i++) {
+		if (EEPROM.update(address++, coefficients[i].min) != EEPROM_OK
+		    || EEPROM.update(address++, coefficients[i].centre) != EEPROM_OK
+		    || EEPROM.update(address++, coefficients[i].max) != EEPROM_OK) {
+			return false;
+		}
+		checksum += coefficients[i].min + coefficients[i].centre + coefficients[i].max;
+	}
+	if (EEPROM.update(address, checksum) != EEPROM_OK) {
+		return false;
+	}
+
+  #ifdef ENABLE_DEBUG_OUTPUT_CHANNELCALIBRATION
+  Serial.println("ChannelCalibration::save completed");
+  #endif
+	return true;
+#else
+	return false;
+#endif
+}
@@ -0,0 +1,159 @@
+/*
+Channel calibration
+
+Maps the channel values (pulse length, us) to the joystick axis range using each channel's
+own endpoints and centre instead of the nominal radio profile values, so the whole joystick range is used
+and nothing is clipped.
+
+Calibration mode (begin() ... end()):
+ - update() is called with every frame and tracks the observed min/max of each channel.
+   A value beyond the current min/max is only accepted after it has been seen in confirmFrames frames
+   in a row, the least extreme of them is taken, so a single spike does not stretch the range.
+ - the centre is tracked while the stick rests near the middle of the range
+   (the value changes by no more than restTolerance for restFrames frames): an exponential average of the resting value.
+   A channel which never rests (e.g. throttle) gets the middle of its range.
+ - after a frame which changed anything new mapping coefficients are calculated.
+ - end() saves the calibration to the flash (EEPROM emulation, STM32 only).
+
+Mapping: two integer linear segments per channel, min..centre and centre..max,
+with Q16 fixed point scales. The coefficients are double buffered: a new set is calculated
+into the inactive buffer and then made active in one step between frames,
+so map() never sees a half updated set and the hot path has no float calculations.
+
+A channel with a span below minSpan keeps the radio profile values.
+
+mapQ4() maps a value in 1/16 us (the fractional output of the median filter) with the same coefficients,
+so the output range is used at a finer step than 1 us; map() is mapQ4() of a whole microsecond value.
+
+TODO:
+
+=================================================================
+(C) 2026 ifh
+This file is part of PPM to USB Joystick.
+
+PPM to USB Joystick is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+PPM to USB Joystick is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+*/
+
+#ifndef CHANNELCALIBRATION_H
+#define CHANNELCALIBRATION_H
+
+#include "Arduino.h"
+#include "RadioProfiles.h"
+
+#define CHANNELCALIBRATION_MAX_CHANNELS 16
+
+//EEPROM emulation layout: a marker, min/centre/max of each channel and a checksum, 16 bit words
+#define CHANNELCALIBRATION_EEPROM_ADDRESS 0
+#define CHANNELCALIBRATION_EEPROM_MARKER 0xCA01
+
+//Mapping coefficients of a channel
+typedef struct channelCoefficients {
+    uint16_t min;
+    uint16_t centre;
+    uint16_t max;
+    uint32_t lowScale;   //output per us below the centre, Q16
+    uint32_t highScale;  //output per us above the centre, Q16
+} channelCoefficients;
+
+
+class ChannelCalibration {
+	public:
+		//Set ChannelCalibration object, the coefficients are from the radio profile
+		ChannelCalibration();
+
+		//Delete ChannelCalibration object
+		~ChannelCalibration();
+
+		//The amount of channels, <= CHANNELCALIBRATION_MAX_CHANNELS
+		uint8_t channelAmount = 8;
+
+		//Output range
+		uint16_t minOutputValue = 0;
+		uint16_t maxOutputValue = 65535;
+
+		//Outlier rejection - frames in a row beyond the current min/max to extend the range
+		uint8_t confirmFrames = 3;
+
+		//Centre detection - the stick is resting if it moves by no more than restTolerance (us)
+		//for restFrames frames and it is within the middle half of the range
+		uint16_t restTolerance = 4;
+		uint8_t restFrames = 20;
+
+		//A calibrated channel shall have at least this span (max - min), us
+		uint16_t minSpan = 200;
+
+		//Code in Ch0 for failsafe condition, failsafe frames are not used for calibration
+		uint16_t codeFailSafe = 0;
+
+		//Starts the calibration mode, the observed ranges are cleared
+		void begin();
+
+		//Updates the observed ranges with a frame and makes new coefficients active if anything changed
+		// parameter channels[] - array from 0 to channelAmount, Ch0 is the failsafe code
+		void update(const uint16_t* channels);
+
+		//Ends the calibration mode and saves the calibration. Returns false if it was not saved
+		bool end();
+
+		//Returns true in the calibration mode
+		bool isCalibrating();
+
+		//Maps a channel value (us) to the output range
+		uint16_t map(uint8_t channel, uint16_t value);
+
+		//Maps a channel value in 1/16 us to the output range
+		uint16_t mapQ4(uint8_t channel, uint32_t valueQ4);
+
+		//Returns the calibrated min/centre/max of a channel, us
+		uint16_t GetMin(uint8_t channel);
+		uint16_t GetCentre(uint8_t channel);
+		uint16_t GetMax(uint8_t channel);
+
+		//Loads/saves the calibration from/to the flash (EEPROM emulation, STM32 only).
+		//Return false if there is no valid calibration or it can not be saved
+		bool load();
+		bool save();
+
+	private:
+		//Two sets of coefficients, map() uses _coefficients[_active]
+		channelCoefficients _coefficients[2][CHANNELCALIBRATION_MAX_CHANNELS + 1];
+		volatile uint8_t _active = 0;
+
+		bool _calibrating = false;
+
+		//Observed values, 1..CHANNELCALIBRATION_MAX_CHANNELS
+		uint16_t _min[CHANNELCALIBRATION_MAX_CHANNELS + 1];
+		uint16_t _max[CHANNELCALIBRATION_MAX_CHANNELS + 1];
+		uint32_t _centre[CHANNELCALIBRATION_MAX_CHANNELS + 1];  //Q4, 0 - not detected yet
+
+		//Outlier rejection state: candidate value and frames it has been seen
+		uint16_t _pendingMin[CHANNELCALIBRATION_MAX_CHANNELS + 1];
+		uint16_t _pendingMax[CHANNELCALIBRATION_MAX_CHANNELS + 1];
+		uint8_t _pendingMinFrames[CHANNELCALIBRATION_MAX_CHANNELS + 1];
+		uint8_t _pendingMaxFrames[CHANNELCALIBRATION_MAX_CHANNELS + 1];
+
+		//Centre detection state
+		uint16_t _lastValue[CHANNELCALIBRATION_MAX_CHANNELS + 1];
+		uint8_t _restFrames[CHANNELCALIBRATION_MAX_CHANNELS + 1];
+
+		//Calculates the coefficients of a channel
+		void setCoefficients(channelCoefficients* coefficients, uint16_t min, uint16_t centre, uint16_t max);
+
+		//Calculates a new set from the observed values / the given values and makes it active
+		void commit();
+		void commit(const uint16_t* min, const uint16_t* centre, const uint16_t* max);
+};
+
+#endif
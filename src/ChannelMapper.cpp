@@ -0,0 +1,290 @@
+/*
+Channel mapper
+
+Table driven mapping of the input channels to the joystick report.
+
+TODO - see the .h file
+=================================================================
+(C) 2026 ifh
+This file is part of PPM to USB Joystick.
+
+PPM to USB Joystick is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+PPM to USB Joystick is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+*/
+
+// Set to true to print some debug messages, or false to disable them.
+//#define ENABLE_DEBUG_OUTPUT_CHANNELMAPPER
+
+#include "Arduino.h"
+#include "ChannelMapper.h"
+
+//Hat directions in degrees for {y = -1, 0, 1} x {x = -1, 0, 1}, -1 - centered
+static const int16_t hatDirections[3][3] = {
+    {225, 180, 135},
+    {270,  -1,  90},
+    {315,   0,  45}
+};
+
+
+/* Set ChannelMapper object */
+ChannelMapper::ChannelMapper() {
+	memset(_state, 0, sizeof(_state));
+}
+
+
+/* Delete ChannelMapper object */
+ChannelMapper::~ChannelMapper() {
+}
+
+
+/* Function to set a new table */
+bool ChannelMapper::setTable(const mappingEntry* entries, uint8_t size) {
+	if (size > CHANNELMAPPER_MAX_ENTRIES) {
+		return false;
+	}
+	memcpy(_tables[_active ^ 1], entries, size * sizeof(mappingEntry));
+	return commit(size);
+}
+
+
+/* Function to check and compact the inactive table and mark it pending.
+Every entry is checked before the table is changed, so a rejected table can be committed again after a fix.
+The axes are moved to the front (in their order), apply() maps them in a loop of their own */
+bool ChannelMapper::commit(uint8_t size) {
+	mappingEntry* table = _tables[_active ^ 1];
+
+	for (uint8_t i=0; i<size; i++) {
+		const mappingEntry& entry = table[i];
+		bool valid = false;
+		switch (entry.type) {
+			case MAPPING_AXIS:
+				valid = entry.target < JOYSTICKREPORT_AXES;
+				break;
+			case MAPPING_BUTTON:
+				//the release level threshold - hysteresis shall not be below 0
+				valid = entry.target >= 1 && entry.target <= JOYSTICKREPORT_BUTTONS
+				        && (entry.threshold == 0 || entry.threshold >= entry.hysteresis);
+				break;
+			case MAPPING_SWITCH:
+				valid = entry.positions >= 2 && entry.positions <= 8
+				        && entry.target >= 1 && entry.target + entry.positions - 1 <= JOYSTICKREPORT_BUTTONS;
+				break;
+			case MAPPING_HAT_X:
+			case MAPPING_HAT_Y:
+				valid = entry.target < JOYSTICKREPORT_HATS;
+				break;
+		}
+		if (!valid || entry.source == 0 || entry.source > CHANNELCALIBRATION_MAX_CHANNELS) {
+			++_uploadErrors;
+			return false;
+		}
+	}
+
+	//channels which are not received are dropped
+	mappingEntry others[CHANNELMAPPER_MAX_ENTRIES];
+	uint8_t used = 0;
+	uint8_t otherCount = 0;
+	uint8_t hats = 0;
+	for (uint8_t i=0; i<size; i++) {
+		const mappingEntry& entry = table[i];
+		if (entry.source > channelAmount) {
+			continue;
+		}
+		if (entry.type == MAPPING_AXIS) {
+			table[used++] = entry;
+		}
+		else
+		{
+			others[otherCount++] = entry;
+		}
+		if (entry.type == MAPPING_HAT_X || entry.type == MAPPING_HAT_Y) {
+			hats |= 1 << entry.target;
+		}
+	}
+	_axisEntries[_active ^ 1] = used;
+	memcpy(&table[used], others, otherCount * sizeof(mappingEntry));
+	used += otherCount;
+
+	_tableSizes[_active ^ 1] = used;
+	_hatMasks[_active ^ 1] = hats;
+	_pending = true;
+
+#ifdef ENABLE_DEBUG_OUTPUT_CHANNELMAPPER
+  Serial.print("ChannelMapper::commit completed, entries: ");
+  Serial.println(used);
+#endif
+	return true;
+}
+
+
+/* Function to handle an upload feature report from the host */
+bool ChannelMapper::receive(const uint8_t* report, uint16_t size) {
+	mappingUploadReport_t upload;
+	if (size < 4) {
+		++_uploadErrors;
+		return false;
+	}
+	memset(&upload, 0, sizeof(upload));
+	memcpy(&upload, report, (size < sizeof(upload)) ? size : sizeof(upload));
+
+	if (upload.command == CHANNELMAPPER_COMMAND_WRITE) {
+		if (upload.count == 0 || upload.count > CHANNELMAPPER_UPLOAD_ENTRIES
+		    || upload.offset + upload.count > CHANNELMAPPER_MAX_ENTRIES
+		    || size < 4 + upload.count * sizeof(mappingEntry)) {
+			++_uploadErrors;
+			return false;
+		}
+		//a table which was not used yet is overwritten
+		_pending = false;
+		memcpy(&_tables[_active ^ 1][upload.offset], upload.entries, upload.count * sizeof(mappingEntry));
+		return true;
+	}
+	if (upload.command == CHANNELMAPPER_COMMAND_COMMIT && upload.count <= CHANNELMAPPER_MAX_ENTRIES) {
+		return commit(upload.count);
+	}
+	++_uploadErrors;
+	return false;
+}
+
+
+/* Function to decode a switch position with hysteresis */
+uint8_t ChannelMapper::switchPosition(uint16_t value, uint16_t min, uint16_t max, uint8_t positions,
+                                      uint8_t hysteresis, uint8_t previous) {
+	uint32_t span = max - min;
+	uint32_t offset = (value > min) ? value - min : 0;
+	uint32_t position = (offset * positions) / (span + 1);
+	if (position >= positions) {
+		position = positions - 1;
+	}
+	if (position > previous) {
+		//the boundary above the previous position
+		if (offset < span * (previous + 1) / positions + hysteresis) {
+			return previous;
+		}
+	}
+	else if (position < previous) {
+		//the boundary below the previous position
+		if (offset + hysteresis > span * previous / positions) {
+			return previous;
+		}
+	}
+	return position;
+}
+
+
+/* Function to map a frame to the joystick report */
+void ChannelMapper::apply(const uint16_t* channels, JoystickReport* report, ChannelCalibration* calibration,
+                          const uint16_t* channelsQ4) {
+	//A new table is taken between frames. The report starts neutral, so an axis, a button or a hat
+	//which the old table drove and the new one does not is not left at its last value
+	if (_pending) {
+		_active ^= 1;
+		_pending = false;
+		memset(_state, 0, sizeof(_state));
+		report->reset();
+	}
+
+	const mappingEntry* table = _tables[_active];
+	uint8_t size = _tableSizes[_active];
+	uint8_t axes = _axisEntries[_active];
+
+	//the axes first, one loop for each resolution
+	if (channelsQ4 != NULL) {
+		for (uint8_t i=0; i<axes; i++) {
+			const mappingEntry& entry = table[i];
+			uint16_t axis = calibration->mapQ4(entry.source, channelsQ4[entry.source]);
+			report->setAxis(entry.target, (entry.flags & MAPPING_INVERT) ? JOYSTICKREPORT_AXIS_MAX + JOYSTICKREPORT_AXIS_MIN - axis : axis);
+		}
+	}
+	else
+	{
+		for (uint8_t i=0; i<axes; i++) {
+			const mappingEntry& entry = table[i];
+			uint16_t axis = calibration->map(entry.source, channels[entry.source]);
+			report->setAxis(entry.target, (entry.flags & MAPPING_INVERT) ? JOYSTICKREPORT_AXIS_MAX + JOYSTICKREPORT_AXIS_MIN - axis : axis);
+		}
+	}
+	if (axes == size) {
+		return;
+	}
+
+	int8_t hatX[JOYSTICKREPORT_HATS + 1] = {0};
+	int8_t hatY[JOYSTICKREPORT_HATS + 1] = {0};
+	for (uint8_t i=axes; i<size; i++) {
+		const mappingEntry& entry = table[i];
+		uint16_t value = channels[entry.source];
+		bool invert = entry.flags & MAPPING_INVERT;
+
+		switch (entry.type) {
+			case MAPPING_BUTTON: {
+				uint16_t threshold = (entry.threshold != 0) ? entry.threshold : calibration->GetCentre(entry.source);
+				//the pressed state needs the value below threshold - hysteresis to be released and vice versa,
+				//saturated as the calibrated centre is not checked by commit()
+				uint32_t level = _state[i] ? ((threshold > entry.hysteresis) ? threshold - entry.hysteresis : 0)
+				                           : (uint32_t)threshold + entry.hysteresis;
+				_state[i] = (value > level);
+				report->setButton(entry.target, _state[i] != invert);
+				break;
+			}
+			case MAPPING_SWITCH: {
+				_state[i] = switchPosition(value, calibration->GetMin(entry.source), calibration->GetMax(entry.source),
+				                           entry.positions, entry.hysteresis, _state[i]);
+				uint8_t position = invert ? entry.positions - 1 - _state[i] : _state[i];
+				for (uint8_t k=0; k<entry.positions; k++) {
+					report->setButton(entry.target + k, k == position);
+				}
+				break;
+			}
+			case MAPPING_HAT_X:
+			case MAPPING_HAT_Y: {
+				//a 3-position switch, the middle position is centered
+				_state[i] = switchPosition(value, calibration->GetMin(entry.source), calibration->GetMax(entry.source),
+				                           3, entry.hysteresis, _state[i]);
+				int8_t direction = (int8_t)_state[i] - 1;
+				direction = invert ? -direction : direction;
+				if (entry.type == MAPPING_HAT_X) {
+					hatX[entry.target] = direction;
+				}
+				else
+				{
+					hatY[entry.target] = direction;
+				}
+				break;
+			}
+		}
+	}
+
+	uint8_t hats = _hatMasks[_active];
+	for (uint8_t k=0; k<JOYSTICKREPORT_HATS && hats != 0; k++) {
+		if (hats & (1 << k)) {
+			report->setHat(k, hatDirections[hatY[k] + 1][hatX[k] + 1]);
+		}
+	}
+}
+
+
+/* Functions to return the active table */
+uint8_t ChannelMapper::GetTableSize() {
+	return _tableSizes[_active];
+}
+
+const mappingEntry* ChannelMapper::GetEntry(uint8_t index) {
+	return (index < _tableSizes[_active]) ? &_tables[_active][index] : NULL;
+}
+
+
+/* Function to return the number of rejected upload reports and tables */
+uint32_t ChannelMapper::GetUploadErrors() {
+	return _uploadErrors;
+}
@@ -0,0 +1,160 @@
+/*
+Channel mapper
+
+Maps the input channels to the joystick axes, buttons and hats with a mapping table,
+so the mapping can be changed from the PC without a reflash.
+
+Each table entry takes one source channel and drives:
+ - MAPPING_AXIS   - axis target (0..JOYSTICKREPORT_AXES-1), through the channel calibration
+ - MAPPING_BUTTON - button target (1..JOYSTICKREPORT_BUTTONS), pressed above threshold (us, 0 - the calibrated centre),
+                    with hysteresis (us) in both directions
+ - MAPPING_SWITCH - a multi-position switch with positions (2..8) positions decoded into positions buttons
+                    from button target, the button of the current position is pressed
+ - MAPPING_HAT_X / MAPPING_HAT_Y - a 3-position switch as the left/right or down/up direction of hat target,
+                    a hat is driven by a HAT_X and a HAT_Y entry
+Axes take the fractional channel values (1/16 us) if they are given to apply(), buttons, switches and hats
+always use the whole microsecond values.
+MAPPING_INVERT in flags inverts the axis, the button or the order of the switch positions.
+Switch positions divide the calibrated range of the channel evenly, a new position is taken
+when the value is hysteresis beyond the boundary.
+
+The table is run once per frame by apply(), only the entries present are processed.
+Entries for channels above channelAmount are dropped when a table is set, the axes are moved to the front
+of the table (GetEntry() gives the table in this order), so apply() maps them without a switch per entry.
+
+New table - two tables are kept, a new one is written into the inactive table and it becomes active
+at the start of the next apply(), so a frame is always mapped with one complete table.
+The report is reset then (centred axes and hats, released buttons), the controls the new table does not drive stay neutral.
+The host uploads a table with the mapping feature report (see receive()):
+  byte 0      - report ID
+  byte 1      - command: 1 - write entries, 2 - commit (use the table)
+  byte 2      - write: index of the first entry; commit: 0
+  byte 3      - write: number of entries in this report (1..CHANNELMAPPER_UPLOAD_ENTRIES); commit: entries in the table
+  bytes 4..   - write: entries, 8 bytes each (mappingEntry)
+A table with an invalid entry (e.g. a button threshold below its hysteresis) is not committed, see GetUploadErrors().
+
+TODO:
+- save the table in the flash
+
+=================================================================
+(C) 2026 ifh
+This file is part of PPM to USB Joystick.
+
+PPM to USB Joystick is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+PPM to USB Joystick is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+*/
+
+#ifndef CHANNELMAPPER_H
+#define CHANNELMAPPER_H
+
+#include "Arduino.h"
+#include "JoystickReport.h"
+#include "ChannelCalibration.h"
+
+#define CHANNELMAPPER_MAX_ENTRIES 48
+
+//Entries in one upload feature report
+#define CHANNELMAPPER_UPLOAD_ENTRIES 6
+
+//Upload commands
+#define CHANNELMAPPER_COMMAND_WRITE 1
+#define CHANNELMAPPER_COMMAND_COMMIT 2
+
+//Entry types
+typedef enum mappingType {
+    MAPPING_NONE = 0,
+    MAPPING_AXIS = 1,
+    MAPPING_BUTTON = 2,
+    MAPPING_SWITCH = 3,
+    MAPPING_HAT_X = 4,
+    MAPPING_HAT_Y = 5
+} mappingType;
+
+//Entry flags
+#define MAPPING_INVERT 0x01
+
+//Mapping table entry, packed as it is uploaded by the host
+typedef struct {
+    uint8_t source;      //input channel, 1..16
+    uint8_t type;        //mappingType
+    uint8_t target;      //axis, first button or hat
+    uint8_t flags;
+    uint16_t threshold;  //button threshold, us, 0 - the calibrated centre
+    uint8_t hysteresis;  //us
+    uint8_t positions;   //switch positions
+} __attribute__((packed)) mappingEntry;
+
+//Upload feature report
+typedef struct {
+    uint8_t reportID;
+    uint8_t command;
+    uint8_t offset;
+    uint8_t count;
+    mappingEntry entries[CHANNELMAPPER_UPLOAD_ENTRIES];
+} __attribute__((packed)) mappingUploadReport_t;
+
+
+class ChannelMapper {
+	public:
+		//Set ChannelMapper object with an empty table
+		ChannelMapper();
+
+		//Delete ChannelMapper object
+		~ChannelMapper();
+
+		//The amount of input channels
+		uint8_t channelAmount = 8;
+
+		//Sets a new table, it is used from the next apply(). Returns false if an entry is invalid
+		bool setTable(const mappingEntry* entries, uint8_t size);
+
+		//Handles an upload feature report from the host. Returns false if it is invalid
+		bool receive(const uint8_t* report, uint16_t size);
+
+		//Maps a frame to the joystick report
+		// parameter channels[] - array from 0 to channelAmount, after the filter
+		// parameter channelsQ4[] - optional, the same channels in 1/16 us (MedianFilter fractional output) for the axes
+		void apply(const uint16_t* channels, JoystickReport* report, ChannelCalibration* calibration,
+		           const uint16_t* channelsQ4 = NULL);
+
+		//Returns the active table
+		uint8_t GetTableSize();
+		const mappingEntry* GetEntry(uint8_t index);
+
+		//Returns the number of rejected upload reports and tables
+		uint32_t GetUploadErrors();
+
+	private:
+		//Two tables, apply() uses _tables[_active] (apply() may run in an interrupt, receive() in loop())
+		mappingEntry _tables[2][CHANNELMAPPER_MAX_ENTRIES];
+		uint8_t _tableSizes[2] = {0, 0};
+		uint8_t _axisEntries[2] = {0, 0};   //the axes are the first entries of a table
+		uint8_t _hatMasks[2] = {0, 0};      //bit mask of the hats a table drives
+		volatile uint8_t _active = 0;
+		volatile bool _pending = false;
+
+		//Button state or switch position of each entry of the active table
+		uint8_t _state[CHANNELMAPPER_MAX_ENTRIES];
+
+		uint32_t _uploadErrors = 0;
+
+		//Checks and compacts the inactive table, marks it pending. Returns false if an entry is invalid
+		bool commit(uint8_t size);
+
+		//Decodes a switch position with hysteresis
+		static uint8_t switchPosition(uint16_t value, uint16_t min, uint16_t max, uint8_t positions,
+		                              uint8_t hysteresis, uint8_t previous);
+};
+
+#endif
@@ -0,0 +1,158 @@
+/*
+Frame scheduler
+
+PendSV request and handler, interrupt priorities and the stage latencies.
+The register names are from libmaple (scb.h, nvic.h) of Arduino_STM32.
+
+TODO - see the .h file
+=================================================================
+(C) 2026 ifh
+This file is part of PPM to USB Joystick.
+
+PPM to USB Joystick is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+PPM to USB Joystick is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+*/
+
+// Set to true to print some debug messages, or false to disable them.
+//#define ENABLE_DEBUG_OUTPUT_FRAMESCHEDULER
+
+#include "Arduino.h"
+#include "FrameScheduler.h"
+
+#ifdef __STM32F1__
+#include <libmaple/nvic.h>
+#include <libmaple/scb.h>
+
+//PendSV handler of the libmaple vector table
+extern "C" void __exc_pendsv(void) {
+	FrameScheduler::run();
+}
+#endif
+
+void (*FrameScheduler::_pipeline)() = NULL;
+volatile bool FrameScheduler::_pending = false;
+
+
+/* Set FrameScheduler object */
+FrameScheduler::FrameScheduler() {
+	reset();
+}
+
+
+/* Delete FrameScheduler object */
+FrameScheduler::~FrameScheduler() {
+}
+
+
+/* Function to set the pipeline handler and the interrupt priorities */
+void FrameScheduler::begin(void (*pipeline)()) {
+	_pipeline = pipeline;
+#ifdef __STM32F1__
+	nvic_irq_set_priority(NVIC_SYSTICK, FRAMESCHEDULER_PRIORITY_SYSTICK);
+	nvic_irq_set_priority(NVIC_PEND_SVC, FRAMESCHEDULER_PRIORITY_PIPELINE);
+#endif
+
+#ifdef ENABLE_DEBUG_OUTPUT_FRAMESCHEDULER
+  Serial.println("FrameScheduler::begin completed");
+#endif
+}
+
+
+/* Function to request the software interrupt, called from the interrupts */
+void FrameScheduler::trigger() {
+	_pending = true;
+#ifdef __STM32F1__
+	SCB_BASE->ICSR = SCB_ICSR_PENDSVSET;
+#endif
+}
+
+
+/* Function to run the pipeline handler, called by the software interrupt.
+The flag is cleared first, so a request during the pipeline runs it again */
+void FrameScheduler::run() {
+	if (!_pending) {
+		return;
+	}
+	_pending = false;
+	if (_pipeline != NULL) {
+		_pipeline();
+	}
+}
+
+
+/* Function to return true if the software interrupt is requested */
+bool FrameScheduler::IsPending() {
+	return _pending;
+}
+
+
+/* Function to record that a frame has reached a stage */
+void FrameScheduler::record(frameStage stage, uint32_t edgeTime, uint32_t time) {
+	if (stage >= FRAMESCHEDULER_STAGES) {
+		return;
+	}
+	uint32_t latency = time - edgeTime;
+	++_count[stage];
+	_sum[stage] += latency;
+	if (latency > _max[stage]) {
+		_max[stage] = latency;
+	}
+}
+
+
+/* Function to clear the stage latencies */
+void FrameScheduler::reset() {
+	for (uint8_t i = 0; i < FRAMESCHEDULER_STAGES; i++) {
+		_count[i] = 0;
+		_sum[i] = 0;
+		_max[i] = 0;
+	}
+}
+
+
+/* Function to return the mean latency to a stage.
+The sum is 64 bit, the pipeline must not update it while it is read */
+uint32_t FrameScheduler::GetMeanLatency(frameStage stage) {
+	if (stage >= FRAMESCHEDULER_STAGES) {
+		return 0;
+	}
+	lock();
+	uint32_t count = _count[stage];
+	uint64_t sum = _sum[stage];
+	unlock();
+	return (count > 0) ? (uint32_t)(sum / count) : 0;
+}
+
+
+/* Function to return the maximum latency to a stage */
+uint32_t FrameScheduler::GetMaxLatency(frameStage stage) {
+	return (stage < FRAMESCHEDULER_STAGES) ? _max[stage] : 0;
+}
+
+
+/* Function to return the number of frames which have reached a stage */
+uint32_t FrameScheduler::GetStageCount(frameStage stage) {
+	return (stage < FRAMESCHEDULER_STAGES) ? _count[stage] : 0;
+}
+
+
+/* Function to write the latency of every stage, saturated to the fields */
+void FrameScheduler::writeLatencies(frameLatencies* latencies) {
+	for (uint8_t i = 0; i < FRAMESCHEDULER_STAGES; i++) {
+		uint32_t mean = GetMeanLatency((frameStage)i);
+		uint32_t max = GetMaxLatency((frameStage)i);
+		latencies->mean[i] = (mean < 0xFFFF) ? mean : 0xFFFF;
+		latencies->max[i] = (max < 0xFFFF) ? max : 0xFFFF;
+	}
+}
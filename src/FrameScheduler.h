@@ -0,0 +1,136 @@
+/*
+Frame scheduler
+
+Priority tiers of the frame pipeline (with ENABLE_DEFERRED_PROCESSING in the sketch):
+ - edge interrupts (EXTI) and the signal loss watchdog (TIMER4): only the edge time (or the loss) is stored
+   (PPMReader::setupDeferredDecode) and the software interrupt is requested with trigger()
+ - software interrupt (PendSV) at the lowest priority: the pipeline handler decodes the queued edges and,
+   when a frame is complete, filters and maps it into a report. It runs as soon as no other interrupt is active,
+   it preempts loop() but never an edge interrupt
+ - thread mode, loop(): hands the finished report to USB, statistics, feature reports, calibration, flash.
+   The report is still sent by loop(), so the "report sent" stage follows loop()
+
+PendSV is the Cortex-M3 exception meant for this, its handler is __exc_pendsv of the libmaple vector table.
+begin() sets the priorities (0 - highest, 15 - lowest): SysTick above the edge interrupts so micros() in the
+edge interrupt is never a tick behind, the edge interrupts (PPMReader::setInterruptPriority) above the rest,
+PendSV lowest. libmaple sets all the other interrupts (USB, DMA) to 15, so they and the pipeline wait
+for each other at most one run, none of them delays an edge.
+loop() takes the result of the pipeline, and changes the mapping and the calibration, between lock() and unlock():
+BASEPRI masks the pipeline priority only, the edge interrupts are never masked.
+
+Stage latencies: the time from the last edge of a frame to each stage (decoded, report ready, report sent),
+mean and maximum over the frames, recorded with record() in the context where the stage is reached.
+writeLatencies() gives them as a part of a feature report (the diagnostics report of the sketch).
+
+On other platforms trigger() only sets a flag and run() is called by the simulator.
+
+TODO:
+- move the USB handoff into the pipeline when the endpoint is free
+
+=================================================================
+(C) 2026 ifh
+This file is part of PPM to USB Joystick.
+
+PPM to USB Joystick is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+PPM to USB Joystick is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+*/
+
+#ifndef FRAMESCHEDULER_H
+#define FRAMESCHEDULER_H
+
+#include "Arduino.h"
+
+//Interrupt priorities, 0 - highest, 15 - lowest
+#define FRAMESCHEDULER_PRIORITY_SYSTICK 12
+#define FRAMESCHEDULER_PRIORITY_EDGE 13
+#define FRAMESCHEDULER_PRIORITY_PIPELINE 15
+
+//Stages of a frame, the latency is from the last edge of the frame
+typedef enum frameStage {
+    FRAME_STAGE_DECODED = 0,   /**decoded, the frame is complete */
+    FRAME_STAGE_READY = 1,     /**filtered and mapped, the report is ready */
+    FRAME_STAGE_SENT = 2       /**the report is handed to USB */
+} frameStage;
+#define FRAMESCHEDULER_STAGES 3
+
+//The stage latencies as a part of a feature report (little endian, packed), us, saturated at 65535
+typedef struct frameLatencies {
+    uint16_t mean[FRAMESCHEDULER_STAGES];
+    uint16_t max[FRAMESCHEDULER_STAGES];
+} __attribute__((packed)) frameLatencies;
+
+
+class FrameScheduler {
+	public:
+		//Set FrameScheduler object
+		FrameScheduler();
+
+		//Delete FrameScheduler object
+		~FrameScheduler();
+
+		//Sets the pipeline handler which runs in the software interrupt and the interrupt priorities
+		void begin(void (*pipeline)());
+
+		//Requests the software interrupt, called from the edge and watchdog interrupts
+		static void trigger();
+
+		//Runs the pipeline handler if it is requested. Called by the software interrupt (and by the simulator)
+		static void run();
+
+		//Returns true if the software interrupt is requested and the pipeline has not run yet
+		static bool IsPending();
+
+		//Thread mode: the pipeline (and the other interrupts at its priority) does not run between lock() and unlock()
+		static inline void lock() {
+#ifdef __STM32F1__
+			uint32_t level = FRAMESCHEDULER_PRIORITY_PIPELINE << 4;
+			asm volatile ("msr basepri, %0" : : "r" (level) : "memory");
+#endif
+		}
+		static inline void unlock() {
+#ifdef __STM32F1__
+			uint32_t level = 0;
+			asm volatile ("msr basepri, %0" : : "r" (level) : "memory");
+#endif
+		}
+
+		//Records that a frame has reached a stage
+		// parameter edgeTime - time of the last edge of the frame (the PPMReader timestamp), us
+		// parameter time - time the stage is reached, us
+		void record(frameStage stage, uint32_t edgeTime, uint32_t time);
+
+		//Clears the stage latencies
+		void reset();
+
+		//Returns the mean and the maximum latency from the last edge of a frame to a stage, us
+		uint32_t GetMeanLatency(frameStage stage);
+		uint32_t GetMaxLatency(frameStage stage);
+
+		//Returns the number of frames which have reached a stage
+		uint32_t GetStageCount(frameStage stage);
+
+		//Writes the mean and the maximum latency of every stage
+		void writeLatencies(frameLatencies* latencies);
+
+	private:
+		static void (*_pipeline)();
+		static volatile bool _pending;
+
+		//Per stage, each one is written by one context only
+		uint32_t _count[FRAMESCHEDULER_STAGES];
+		uint64_t _sum[FRAMESCHEDULER_STAGES];
+		uint32_t _max[FRAMESCHEDULER_STAGES];
+};
+
+#endif
@@ -0,0 +1,280 @@
+/*
+USB HID Joystick report
+
+A custom HID joystick with up to 16 axes at 16 bits, buttons and hat switches.
+
+HID references: Device Class Definition for HID 1.11, HID Usage Tables 1.12
+
+TODO - see the .h file
+=================================================================
+(C) 2026 ifh
+This file is part of PPM to USB Joystick.
+
+PPM to USB Joystick is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+PPM to USB Joystick is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+*/
+
+// Set to true to print some debug messages, or false to disable them.
+//#define ENABLE_DEBUG_OUTPUT_JOYSTICKREPORT
+
+#include "Arduino.h"
+#include "JoystickReport.h"
+
+//Short items of the report descriptor, the size of the data is included
+#define HID_USAGE_PAGE        0x05
+#define HID_USAGE_PAGE16      0x06
+#define HID_USAGE             0x09
+#define HID_USAGE_MINIMUM     0x19
+#define HID_USAGE_MAXIMUM     0x29
+#define HID_COLLECTION        0xA1
+#define HID_END_COLLECTION    0xC0
+#define HID_REPORT_ID         0x85
+#define HID_LOGICAL_MINIMUM   0x15
+#define HID_LOGICAL_MAXIMUM   0x25
+#define HID_LOGICAL_MAXIMUM16 0x26
+#define HID_LOGICAL_MAXIMUM32 0x27
+#define HID_PHYSICAL_MINIMUM  0x35
+#define HID_PHYSICAL_MAXIMUM16 0x46
+#define HID_UNIT              0x65
+#define HID_REPORT_SIZE       0x75
+#define HID_REPORT_COUNT      0x95
+#define HID_INPUT             0x81
+#define HID_FEATURE           0xB1
+
+//Data values for the main items
+#define HID_DATA_VARIABLE_ABSOLUTE 0x02
+#define HID_CONSTANT               0x03
+#define HID_DATA_VARIABLE_NULL     0x42
+
+//Usages of the axes in the report order
+static const uint8_t axisUsages[16] = {
+    0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37,  //X, Y, Z, Rx, Ry, Rz, Slider, Dial
+    0x38, 0x40, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46   //Wheel, Vx, Vy, Vz, Vbrx, Vbry, Vbrz, Vno
+};
+
+
+/* Set JoystickReport object */
+JoystickReport::JoystickReport(uint8_t reportID) {
+	this->reportID = reportID;
+	reset();
+
+	buildDescriptor();
+}
+
+
+/* Delete JoystickReport object */
+JoystickReport::~JoystickReport() {
+}
+
+
+/* Functions to append report descriptor items */
+void JoystickReport::addItem(uint8_t item) {
+	if (_descriptorSize < JOYSTICKREPORT_MAX_DESCRIPTOR_SIZE) {
+		_descriptor[_descriptorSize++] = item;
+	}
+}
+
+void JoystickReport::addItem(uint8_t item, uint8_t value) {
+	addItem(item);
+	addItem(value);
+}
+
+void JoystickReport::addItem16(uint8_t item, uint16_t value) {
+	addItem(item);
+	addItem(value & 0xFF);
+	addItem(value >> 8);
+}
+
+void JoystickReport::addItem32(uint8_t item, uint32_t value) {
+	addItem(item);
+	addItem(value & 0xFF);
+	addItem((value >> 8) & 0xFF);
+	addItem((value >> 16) & 0xFF);
+	addItem(value >> 24);
+}
+
+
+/* Function to build the report descriptor, it shall match joystickReport_t */
+void JoystickReport::buildDescriptor() {
+	_descriptorSize = 0;
+
+	addItem(HID_USAGE_PAGE, 0x01);      //Generic Desktop
+	addItem(HID_USAGE, 0x04);           //Joystick
+	addItem(HID_COLLECTION, 0x01);      //Application
+	addItem(HID_REPORT_ID, reportID);
+
+	//Axes, 16 bits each
+	addItem(HID_USAGE_PAGE, 0x01);
+	for (uint8_t i=0; i<JOYSTICKREPORT_AXES; i++) {
+		addItem(HID_USAGE, axisUsages[i]);
+	}
+	addItem(HID_LOGICAL_MINIMUM, JOYSTICKREPORT_AXIS_MIN);
+	addItem32(HID_LOGICAL_MAXIMUM32, JOYSTICKREPORT_AXIS_MAX); //4 bytes as the value is signed
+	addItem(HID_REPORT_SIZE, 16);
+	addItem(HID_REPORT_COUNT, JOYSTICKREPORT_AXES);
+	addItem(HID_INPUT, HID_DATA_VARIABLE_ABSOLUTE);
+
+#if JOYSTICKREPORT_BUTTONS > 0
+	//Buttons, 1 bit each, padded to a whole byte
+	addItem(HID_USAGE_PAGE, 0x09);      //Button
+	addItem(HID_USAGE_MINIMUM, 1);
+	addItem(HID_USAGE_MAXIMUM, JOYSTICKREPORT_BUTTONS);
+	addItem(HID_LOGICAL_MINIMUM, 0);
+	addItem(HID_LOGICAL_MAXIMUM, 1);
+	addItem(HID_REPORT_SIZE, 1);
+	addItem(HID_REPORT_COUNT, JOYSTICKREPORT_BUTTONS);
+	addItem(HID_INPUT, HID_DATA_VARIABLE_ABSOLUTE);
+  #if (JOYSTICKREPORT_BUTTONS % 8) != 0
+	addItem(HID_REPORT_COUNT, 8 - (JOYSTICKREPORT_BUTTONS % 8));
+	addItem(HID_INPUT, HID_CONSTANT);
+  #endif
+#endif
+
+#if JOYSTICKREPORT_HATS > 0
+	//Hat switches, 4 bits each, 0..7 in 45 degree steps, out of range value means centered
+	addItem(HID_USAGE_PAGE, 0x01);
+	for (uint8_t i=0; i<JOYSTICKREPORT_HATS; i++) {
+		addItem(HID_USAGE, 0x39);       //Hat switch
+	}
+	addItem(HID_LOGICAL_MINIMUM, 0);
+	addItem(HID_LOGICAL_MAXIMUM, 7);
+	addItem(HID_PHYSICAL_MINIMUM, 0);
+	addItem16(HID_PHYSICAL_MAXIMUM16, 315);
+	addItem(HID_UNIT, 0x14);            //English rotation, degrees
+	addItem(HID_REPORT_SIZE, 4);
+	addItem(HID_REPORT_COUNT, JOYSTICKREPORT_HATS);
+	addItem(HID_INPUT, HID_DATA_VARIABLE_NULL);
+	addItem(HID_UNIT, 0x00);
+  #if (JOYSTICKREPORT_HATS % 2) != 0
+	addItem(HID_REPORT_COUNT, 1);
+	addItem(HID_INPUT, HID_CONSTANT);
+  #endif
+#endif
+
+	addItem(HID_END_COLLECTION);
+
+	//Vendor defined feature reports, bytes, in their own application collection,
+	//so the host does not take them as controls of the joystick
+	if (_featureReportAmount > 0) {
+		addItem16(HID_USAGE_PAGE16, 0xFF00);
+		addItem(HID_USAGE, 0x01);
+		addItem(HID_COLLECTION, 0x01);  //Application
+		for (uint8_t i=0; i<_featureReportAmount; i++) {
+			addItem(HID_USAGE, i + 1);
+			addItem(HID_REPORT_ID, _featureReportIDs[i]);
+			addItem(HID_LOGICAL_MINIMUM, 0);
+			addItem16(HID_LOGICAL_MAXIMUM16, 255);
+			addItem(HID_REPORT_SIZE, 8);
+			addItem(HID_REPORT_COUNT, _featureReportSizes[i]);
+			addItem(HID_FEATURE, HID_DATA_VARIABLE_ABSOLUTE);
+		}
+		addItem(HID_END_COLLECTION);
+	}
+
+#ifdef ENABLE_DEBUG_OUTPUT_JOYSTICKREPORT
+  Serial.print("JoystickReport::buildDescriptor completed, size: ");
+  Serial.println(_descriptorSize);
+#endif
+}
+
+
+/* Function to add a vendor defined feature report to the descriptor */
+bool JoystickReport::addFeatureReport(uint8_t reportID, uint8_t size) {
+	if (_featureReportAmount >= JOYSTICKREPORT_MAX_FEATURE_REPORTS || reportID == this->reportID) {
+		return false;
+	}
+	_featureReportIDs[_featureReportAmount] = reportID;
+	_featureReportSizes[_featureReportAmount] = size;
+	++_featureReportAmount;
+	buildDescriptor();
+	return true;
+}
+
+
+/* Function to return the report descriptor */
+const uint8_t* JoystickReport::GetDescriptor() {
+	return _descriptor;
+}
+
+/* Function to return the report descriptor size in bytes */
+uint16_t JoystickReport::GetDescriptorSize() {
+	return _descriptorSize;
+}
+
+/* Function to return the input report buffer */
+uint8_t* JoystickReport::GetReport() {
+	return (uint8_t*)&_report;
+}
+
+/* Function to return the input report size in bytes */
+uint16_t JoystickReport::GetReportSize() {
+	return sizeof(_report);
+}
+
+
+/* Function to set an axis value */
+void JoystickReport::setAxis(uint8_t axis, uint16_t value) {
+	if (axis < JOYSTICKREPORT_AXES) {
+		_report.axes[axis] = value;
+	}
+}
+
+
+/* Function to set a button state, buttons are numbered from 1 */
+void JoystickReport::setButton(uint8_t button, bool value) {
+#if JOYSTICKREPORT_BUTTONS > 0
+	if (button == 0 || button > JOYSTICKREPORT_BUTTONS) {
+		return;
+	}
+	uint8_t mask = 1 << ((button - 1) & 7);
+	if (value) {
+		_report.buttons[(button - 1) >> 3] |= mask;
+	}
+	else
+	{
+		_report.buttons[(button - 1) >> 3] &= ~mask;
+	}
+#endif
+}
+
+
+/* Function to centre the axes and the hats and release the buttons */
+void JoystickReport::reset() {
+	memset(&_report, 0, sizeof(_report));
+	_report.reportID = reportID;
+	for (uint8_t i=0; i<JOYSTICKREPORT_AXES; i++) {
+		_report.axes[i] = (JOYSTICKREPORT_AXIS_MAX - JOYSTICKREPORT_AXIS_MIN) / 2;
+	}
+#if JOYSTICKREPORT_HATS > 0
+	for (uint8_t i=0; i<JOYSTICKREPORT_HATS; i++) {
+		setHat(i, -1);
+	}
+#endif
+}
+
+
+/* Function to set a hat direction in degrees or -1 for centered */
+void JoystickReport::setHat(uint8_t hat, int16_t direction) {
+#if JOYSTICKREPORT_HATS > 0
+	if (hat >= JOYSTICKREPORT_HATS) {
+		return;
+	}
+	uint8_t value = JOYSTICKREPORT_HAT_CENTERED;
+	if (direction >= 0) {
+		value = ((direction + 22) / 45) & 7;  //round to the nearest 45 degree step
+	}
+	uint8_t shift = (hat & 1) ? 4 : 0;
+	_report.hats[hat >> 1] = (_report.hats[hat >> 1] & ~(0x0F << shift)) | (value << shift);
+#endif
+}
@@ -0,0 +1,143 @@
+/*
+USB HID Joystick report
+
+A custom HID joystick with up to 16 axes at 16 bits, buttons and hat switches.
+The report descriptor is built from the number of axes/buttons/hats configured below
+and the input report is written into a packed structure that matches the descriptor byte by byte,
+so it can be sent with a HIDReporter of the USB Composite library:
+
+  JoystickReport Report;
+  HIDReporter Reporter(HID, Report.GetReport(), Report.GetReportSize(), Report.reportID);
+  HID.begin(Report.GetDescriptor(), Report.GetDescriptorSize());
+  ...
+  Report.setAxis(0, value);
+  Reporter.sendReport();
+
+Report layout (little endian):
+  byte 0                         - report ID
+  bytes 1..2*JOYSTICKREPORT_AXES - axes, uint16_t, 0..65535
+  next (BUTTONS+7)/8 bytes       - buttons, one bit per button, button 1 is bit 0 of the first byte
+  next (HATS+1)/2 bytes          - hats, 4 bits per hat, 0..7 is the direction in 45 degree steps, 15 is centered
+
+Vendor defined feature reports (e.g. the signal statistics) can be added to the descriptor
+with addFeatureReport() before it is passed to HID.begin(). They are in a vendor defined (0xFF00)
+application collection of their own after the joystick collection. They are read by the host
+with GET_REPORT(Feature) on the control endpoint, so they do not delay the input reports.
+
+TODO:
+
+=================================================================
+(C) 2026 ifh
+This file is part of PPM to USB Joystick.
+
+PPM to USB Joystick is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+PPM to USB Joystick is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+*/
+
+#ifndef JOYSTICKREPORT_H
+#define JOYSTICKREPORT_H
+
+#include "Arduino.h"
+
+//Report configuration
+//Axes use the usages X, Y, Z, Rx, Ry, Rz, Slider, Dial, Wheel, Vx, Vy, Vz, Vbrx, Vbry, Vbrz, Vno in this order
+#define JOYSTICKREPORT_AXES 16      //1..16
+#define JOYSTICKREPORT_BUTTONS 16   //0..32
+#define JOYSTICKREPORT_HATS 1       //0..4
+
+//Requested polling interval of the interrupt IN endpoint (bInterval), milliseconds
+#define JOYSTICKREPORT_POLL_INTERVAL_MS 1
+
+//Axis range
+#define JOYSTICKREPORT_AXIS_MIN 0
+#define JOYSTICKREPORT_AXIS_MAX 65535
+
+//Hat value for the centered position
+#define JOYSTICKREPORT_HAT_CENTERED 15
+
+#define JOYSTICKREPORT_MAX_DESCRIPTOR_SIZE 256
+
+//Vendor defined feature reports in the descriptor
+#define JOYSTICKREPORT_MAX_FEATURE_REPORTS 6
+
+//Input report, packed to match the report descriptor
+typedef struct {
+    uint8_t reportID;
+    uint16_t axes[JOYSTICKREPORT_AXES];
+#if JOYSTICKREPORT_BUTTONS > 0
+    uint8_t buttons[(JOYSTICKREPORT_BUTTONS + 7) / 8];
+#endif
+#if JOYSTICKREPORT_HATS > 0
+    uint8_t hats[(JOYSTICKREPORT_HATS + 1) / 2];
+#endif
+} __attribute__((packed)) joystickReport_t;
+
+
+class JoystickReport {
+	public:
+		//Set JoystickReport object, builds the report descriptor
+		JoystickReport(uint8_t reportID = 1);
+
+		//Delete JoystickReport object
+		~JoystickReport();
+
+		//Report ID of the input report
+		uint8_t reportID;
+
+		//Returns the report descriptor and its size in bytes
+		const uint8_t* GetDescriptor();
+		uint16_t GetDescriptorSize();
+
+		//Returns the input report buffer (including the report ID) and its size in bytes
+		uint8_t* GetReport();
+		uint16_t GetReportSize();
+
+		//Set an axis (0..JOYSTICKREPORT_AXES-1) value, 0..65535
+		void setAxis(uint8_t axis, uint16_t value);
+
+		//Set a button (1..JOYSTICKREPORT_BUTTONS) state
+		void setButton(uint8_t button, bool value);
+
+		//Set a hat (0..JOYSTICKREPORT_HATS-1) direction in degrees (0, 45, ... 315) or -1 for centered
+		void setHat(uint8_t hat, int16_t direction);
+
+		//Centres the axes and the hats and releases the buttons
+		void reset();
+
+		//Adds a vendor defined feature report of size bytes (without the report ID) to the descriptor,
+		//the descriptor is rebuilt. Returns false if there is no room for it.
+		bool addFeatureReport(uint8_t reportID, uint8_t size);
+
+	private:
+		joystickReport_t _report;
+
+		uint8_t _descriptor[JOYSTICKREPORT_MAX_DESCRIPTOR_SIZE];
+		uint16_t _descriptorSize = 0;
+
+		//Feature reports: report ID and size in bytes
+		uint8_t _featureReportIDs[JOYSTICKREPORT_MAX_FEATURE_REPORTS];
+		uint8_t _featureReportSizes[JOYSTICKREPORT_MAX_FEATURE_REPORTS];
+		uint8_t _featureReportAmount = 0;
+
+		//These functions append report descriptor items
+		void addItem(uint8_t item);
+		void addItem(uint8_t item, uint8_t value);
+		void addItem16(uint8_t item, uint16_t value);
+		void addItem32(uint8_t item, uint32_t value);
+
+		//Builds the report descriptor
+		void buildDescriptor();
+};
+
+#endif
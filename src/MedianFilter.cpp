@@ -55,17 +55,14 @@ MedianFilter::MedianFilter() {
 
 	
 	//Fill up arrays for historical values with the default value 	
-	for (uint8_t i=1; i<=channelAmountIn; i++) {
-		_queuePosition1[i]=DefaultInputValue;	
-		_queuePosition2[i]=DefaultInputValue;
-		_queuePosition3[i]=DefaultInputValue;		
-		_queuePosition4[i]=DefaultInputValue;
-		_queuePosition5[i]=DefaultInputValue;
-		
+	for (uint8_t k=0; k<MEDIANFILTER_MAX_WINDOW; k++) {
+		for (uint8_t i=0; i<=16; i++) {
+			_history[k][i]=DefaultInputValue;	
+		}
     }	
 		
 	//Set the pointer 	
-	_queuePointer = 1;	
+	_newest = 0;	
 }
 
 
@@ -76,11 +73,40 @@ MedianFilter::~MedianFilter() {
 }
   
    
- //This function updates applies 5-point median filter.  
+ //This function applies the median filter with the window selected by maxWindowTime.  
 // parameter chIN[] - an array of input values from receiver, pulse length in us 
 // parameter chOUT[] - an array of output to servo driver, pulse length in us
+// parameter timeStamp - time when the input frame was received, us  
 // function output - chOUT[] array updated  
-void MedianFilter::ApplyFilter(uint16_t chIN[0], uint16_t chOUT[0]){ 
+// parameter chOUT_Q4[] - optional, an array of output values, the trimmed mean of the window in 1/16 us  
+void MedianFilter::ApplyFilter(uint16_t chIN[0], uint16_t chOUT[0], uint32_t timeStamp, uint16_t* chOUT_Q4){ 
+  //A gap of the signal, start again from the next frame  
+  if (reseedGap != 0 && _lastTimeStamp != 0 && timeStamp - _lastTimeStamp > reseedGap) {
+    _seeded = false;
+  }
+  updateWindowSize(timeStamp);
+  ApplyFilter(chIN, chOUT, chOUT_Q4);
+}
+
+
+//This function makes the filter fill the history with the next valid frame 
+void MedianFilter::Reset(){ 
+  _seeded = false;
+}
+
+
+//This function returns true if the history has been filled with a valid frame 
+bool MedianFilter::IsSeeded(){ 
+  return _seeded;
+}
+
+
+ //This function updates applies the median filter.  
+// parameter chIN[] - an array of input values from receiver, pulse length in us 
+// parameter chOUT[] - an array of output to servo driver, pulse length in us
+// parameter chOUT_Q4[] - optional, an array of output values, the trimmed mean of the window in 1/16 us  
+// function output - chOUT[] array updated  
+void MedianFilter::ApplyFilter(uint16_t chIN[0], uint16_t chOUT[0], uint16_t* chOUT_Q4){ 
 #ifdef ENABLE_DEBUG_OUTPUT_FILTER 
   Serial.println("MedianFilter::ApplyFilter started"); 
 #endif
@@ -97,157 +123,94 @@ void MedianFilter::ApplyFilter(uint16_t chIN[0], uint16_t chOUT[0]){
  _timestamp=micros();
 
 //=======CALCULATIONS STARTED========================================================= 
- 
-		   //Set the array for historical values per channel  
-           uint16_t v[5];
- 
- // Quick and dirty compilation of historical values for a channel from arrays of historical values based on the queue pointer
- // for 5 point filter only
-#ifdef ENABLE_DEBUG_OUTPUT_FILTER  
-        Serial.println("queuePointer=" + _queuePointer);
-		Serial.println(AA);
-		Serial.println(_queuePointer);
- #endif
- 
- switch(_queuePointer)
-    {
-        case 1:
-		   //Put the input values into the appropriate queue array
-		  for (uint8_t i=1; i<=channelAmountIn; i++) {
-		  _queuePosition1[i]=chIN[i];	
-          }
-
-		  
-		  //For each channel 
-		  for (uint8_t i=1; i<=channelAmountIn; i++) {
-	          
-		     //Set the array for historical values, oldest value has array index as 0
-             v[4]=_queuePosition1[i]; //the latest data
-		     v[3]=_queuePosition5[i];
-		     v[2]=_queuePosition4[i];
-			 v[1]=_queuePosition3[i];
-			 v[0]=_queuePosition2[i]; //the oldest data
-			 
-			 //Apply median filter and put the value into output array 
-			 
-			 	#ifdef ENABLE_DEBUG_OUTPUT_FILTER 
-				  Serial.println("quickMedianFilter5_16 about to started"); 
-						  // Print values from all input channels
-						for (int i = 0; i <= 4; ++i) {
-						Serial.print("v"+ String(i)+":"+String(v[i]) + " ");
-						}
-						Serial.println();
-				#endif
-			 chOUT[i] = quickMedianFilter5_16(v);
-		  }
-            break;
-
-        case 2:
-		   //Put the input values into the appropriate queue array
-		  for (uint8_t i=1; i<=channelAmountIn; i++) {
-		  _queuePosition2[i]=chIN[i];	
-          }
-
-		  
-		  //For each channel 
-		  for (uint8_t i=1; i<=channelAmountIn; i++) {
-	          
-		     //Set the array for historical values
-             v[4]=_queuePosition2[i]; //the latest data
-		     v[3]=_queuePosition1[i];
-		     v[2]=_queuePosition5[i];
-			 v[1]=_queuePosition4[i];
-			 v[0]=_queuePosition3[i]; //the oldest data
-			 
-			 //Apply median filter and put the value into output array 
-			 chOUT[i] = quickMedianFilter5_16(v);
-		  }
-            break;
-
-        case 3:
-		   //Put the input values into the appropriate queue array
-		  for (uint8_t i=1; i<=channelAmountIn; i++) {
-		  _queuePosition3[i]=chIN[i];	
-          }
-
-		  
-		  //For each channel 
-		  for (uint8_t i=1; i<=channelAmountIn; i++) {
-	          
-		     //Set the array for historical values
-             v[4]=_queuePosition3[i]; //the latest data
-		     v[3]=_queuePosition2[i];
-		     v[2]=_queuePosition1[i];
-			 v[1]=_queuePosition5[i];
-			 v[0]=_queuePosition4[i]; //the oldest data
-			 
-			 //Apply median filter and put the value into output array 
-			 chOUT[i] = quickMedianFilter5_16(v);
-		  }
-            break;
-
-        case 4:
-		   //Put the input values into the appropriate queue array
-		  for (uint8_t i=1; i<=channelAmountIn; i++) {
-		  _queuePosition4[i]=chIN[i];	
-          }
-
-		  
-		  //For each channel 
-		  for (uint8_t i=1; i<=channelAmountIn; i++) {
-	          
-		     //Set the array for historical values
-             v[4]=_queuePosition4[i]; //the latest data
-		     v[3]=_queuePosition3[i];
-		     v[2]=_queuePosition2[i];
-			 v[1]=_queuePosition1[i];
-			 v[0]=_queuePosition5[i]; //the oldest data
-			 
-			 //Apply median filter and put the value into output array 
-			 chOUT[i] = quickMedianFilter5_16(v);
-		  }
-            break;
-			
-        case 5:
-		   //Put the input values into the appropriate queue array
-		  for (uint8_t i=1; i<=channelAmountIn; i++) {
-		  _queuePosition5[i]=chIN[i];	
-          }
-
-		  
-		  //For each channel 
-		  for (uint8_t i=1; i<=channelAmountIn; i++) {
-	          
-		     //Set the array for historical values
-             v[4]=_queuePosition5[i]; //the latest data
-		     v[3]=_queuePosition4[i];
-		     v[2]=_queuePosition3[i];
-			 v[1]=_queuePosition2[i];
-			 v[0]=_queuePosition1[i]; //the oldest data
-			 
-			 //Apply median filter and put the value into output array 
-			 chOUT[i] = quickMedianFilter5_16(v);
-		  }
-            break;
-	   #ifdef ENABLE_DEBUG_OUTPUT_FILTER
-        default:
-	
-          Serial.println("FUCK" ) ;
-		#endif  
-    }
 
+  //Failsafe frames are passed through, the history is filled again when the signal is back 
+  if (chIN[0] == codeFailSafe) {
+    _seeded = false;
+    for (uint8_t i=1; i<=channelAmountIn; i++) {
+      chOUT[i] = chIN[i];
+      if (chOUT_Q4 != NULL) {
+        chOUT_Q4[i] = chIN[i] << 4;
+      }
+    }
+    CalculationTime = micros() - _timestamp;
+    return;
+  }
 
+  //The first valid frame fills the whole history, so the output starts with it 
+  if (!_seeded) {
+    for (uint8_t k=0; k<MEDIANFILTER_MAX_WINDOW; k++) {
+      for (uint8_t i=1; i<=channelAmountIn; i++) {
+        _history[k][i]=chIN[i];
+      }
+    }
+    _seeded = true;
+  }
  
+  //Put the input values into the next position of the circular buffer, it replaces the oldest values 
+  _newest = (_newest + 1 < MEDIANFILTER_MAX_WINDOW) ? _newest + 1 : 0;
+  for (uint8_t i=1; i<=channelAmountIn; i++) {
+    _history[_newest][i]=chIN[i];	
+  }
+
+  //Positions of the values in the window, the oldest value has array index as 0 
+  uint8_t n = _windowSize;
+  uint8_t positions[MEDIANFILTER_MAX_WINDOW];
+  uint8_t k = _newest;
+  for (int8_t j=n-1; j>=0; j--) {
+    positions[j] = k;
+    k = (k > 0) ? k - 1 : MEDIANFILTER_MAX_WINDOW - 1;
+  }
+
+#ifdef ENABLE_DEBUG_OUTPUT_FILTER  
+        Serial.print("window=");
+        Serial.println(n);
+#endif
+
+  //Values kept for the trimmed mean 
+  uint8_t trim = (2 * trimPoints < n) ? trimPoints : (n - 1) / 2;
+  uint8_t kept = n - 2 * trim;
+
+  //For each channel 
+  uint16_t v[MEDIANFILTER_MAX_WINDOW];
+  for (uint8_t i=1; i<=channelAmountIn; i++) {
+     //Set the array for historical values, oldest value has array index as 0
+     for (uint8_t j=0; j<n; j++) {
+       v[j]=_history[positions[j]][i];
+     }
+
+     //Fractional output - the window is sorted once for the median and the trimmed mean  
+     if (chOUT_Q4 != NULL) {
+       sortWindow(v, n);
+       uint32_t sum = 0;
+       for (uint8_t j=trim; j<n-trim; j++) {
+         sum += v[j];
+       }
+       chOUT[i] = v[n / 2];
+       chOUT_Q4[i] = ((sum << 4) + kept / 2) / kept;
+       continue;
+     }
+
+     //Apply median filter and put the value into output array 
+     switch(n)
+     {
+       case 3:
+         chOUT[i] = quickMedianFilter3_16(v);
+         break;
+       case 5:
+         chOUT[i] = quickMedianFilter5_16(v);
+         break;
+       case 7:
+         chOUT[i] = quickMedianFilter7_16(v);
+         break;
+       case 9:
+         chOUT[i] = quickMedianFilter9_16(v);
+         break;
+       default:
+         chOUT[i] = v[0];
+     }
+  }
 
-	
-  //set queue pointer to the next array so new input values can be recorded there 
-  _queuePointer=_queuePointer +1;
-  if(_queuePointer > 5) {_queuePointer=1;}
-  
-  
- // Serial.println("queuePointer2=" + _queuePointer);
-  
-  
  //=======CALCULATIONS COMPLETED=====================================================
  
   CalculationTime = micros() - _timestamp;
@@ -267,6 +230,78 @@ void MedianFilter::ApplyFilter(uint16_t chIN[0], uint16_t chOUT[0]){
 } 
 
 
+//This function measures the frame interval and selects the window size for maxWindowTime.
+//A new window size is used only after it has been selected for MEDIANFILTER_WINDOW_SETTLE_FRAMES frames,
+//so a single late or early frame does not change it.
+// parameter timeStamp - time when the input frame was received, us 
+void MedianFilter::updateWindowSize(uint32_t timeStamp){ 
+  uint32_t interval = timeStamp - _lastTimeStamp;
+  bool first = (_lastTimeStamp == 0);
+  _lastTimeStamp = timeStamp;
+  if (first || interval == 0 || maxWindowTime == 0) {
+    return;
+  }
+
+  //Smooth the interval, ignore gaps (e.g. a lost signal),
+  //but a run of long intervals is a slower radio, the interval is measured again
+  if (_frameInterval == 0) {
+    _frameInterval = interval;
+  }
+  else if (interval < 4 * _frameInterval) {
+    _frameInterval = _frameInterval + ((int32_t)(interval - _frameInterval) / 8);
+    _longIntervals = 0;
+  }
+  else if (++_longIntervals >= MEDIANFILTER_INTERVAL_RESET_FRAMES) {
+    _frameInterval = interval;
+    _longIntervals = 0;
+  }
+
+  //The largest odd window which fits into the time budget
+  uint8_t size = MEDIANFILTER_MAX_WINDOW;
+  while (size > 1 && size * _frameInterval > maxWindowTime) {
+    size -= 2;
+  }
+
+  if (size == _windowSize) {
+    _candidateFrames = 0;
+    return;
+  }
+  if (size != _candidateWindowSize) {
+    _candidateWindowSize = size;
+    _candidateFrames = 0;
+  }
+  if (++_candidateFrames >= MEDIANFILTER_WINDOW_SETTLE_FRAMES) {
+    _windowSize = size;
+    _candidateFrames = 0;
+  }
+} 
+
+
+//This function sorts the window values in place, insertion sort (at most 9 values)
+void MedianFilter::sortWindow(uint16_t * v, uint8_t n){ 
+  for (uint8_t j=1; j<n; j++) {
+    uint16_t value = v[j];
+    int8_t k = j - 1;
+    while (k >= 0 && v[k] > value) {
+      v[k + 1] = v[k];
+      --k;
+    }
+    v[k + 1] = value;
+  }
+}
+
+
+//This function returns the window size in use, points
+uint8_t MedianFilter::GetWindowSize(){ 
+  return _windowSize;
+}
+
+
+//This function returns the measured frame interval, us
+uint32_t MedianFilter::GetFrameInterval(){ 
+  return _frameInterval;
+}
+
 
 
 
@@ -383,6 +418,19 @@ uint32_t MedianFilter::quickMedianFilter7_32(uint32_t * v)
     return p[3];
 }
 
+uint16_t MedianFilter::quickMedianFilter7_16(uint16_t * v)
+{
+    uint16_t p[7];
+    memcpy(p, v, sizeof(p));
+
+    QMF_SORT(uint16_t, p[0], p[5]); QMF_SORT(uint16_t, p[0], p[3]); QMF_SORT(uint16_t, p[1], p[6]);
+    QMF_SORT(uint16_t, p[2], p[4]); QMF_SORT(uint16_t, p[0], p[1]); QMF_SORT(uint16_t, p[3], p[5]);
+    QMF_SORT(uint16_t, p[2], p[6]); QMF_SORT(uint16_t, p[2], p[3]); QMF_SORT(uint16_t, p[3], p[6]);
+    QMF_SORT(uint16_t, p[4], p[5]); QMF_SORT(uint16_t, p[1], p[4]); QMF_SORT(uint16_t, p[1], p[3]);
+    QMF_SORT(uint16_t, p[3], p[4]);
+    return p[3];
+}
+
 uint32_t MedianFilter::quickMedianFilter9_32(uint32_t * v)
 {
     uint32_t p[9];
@@ -398,3 +446,19 @@ uint32_t MedianFilter::quickMedianFilter9_32(uint32_t * v)
     return p[4];
 
 }
+
+uint16_t MedianFilter::quickMedianFilter9_16(uint16_t * v)
+{
+    uint16_t p[9];
+    memcpy(p, v, sizeof(p));
+
+    QMF_SORT(uint16_t, p[1], p[2]); QMF_SORT(uint16_t, p[4], p[5]); QMF_SORT(uint16_t, p[7], p[8]);
+    QMF_SORT(uint16_t, p[0], p[1]); QMF_SORT(uint16_t, p[3], p[4]); QMF_SORT(uint16_t, p[6], p[7]);
+    QMF_SORT(uint16_t, p[1], p[2]); QMF_SORT(uint16_t, p[4], p[5]); QMF_SORT(uint16_t, p[7], p[8]);
+    QMF_SORT(uint16_t, p[0], p[3]); QMF_SORT(uint16_t, p[5], p[8]); QMF_SORT(uint16_t, p[4], p[7]);
+    QMF_SORT(uint16_t, p[3], p[6]); QMF_SORT(uint16_t, p[1], p[4]); QMF_SORT(uint16_t, p[2], p[5]);
+    QMF_SORT(uint16_t, p[4], p[7]); QMF_SORT(uint16_t, p[4], p[2]); QMF_SORT(uint16_t, p[6], p[4]);
+    QMF_SORT(uint16_t, p[4], p[2]);
+    return p[4];
+
+}
@@ -2,7 +2,25 @@
 RC Signal Median filter 
 
 The median filter shall reduce effect of potential jitter/outlier values for RC channels. 
-5-point median filtering is used. 
+5-point median filtering is used by default. 
+
+The window can be given as a time budget instead (maxWindowTime): the frame interval is measured
+from the frame timestamps and the filter uses the largest 1, 3, 5, 7 or 9-point window
+which covers no more than maxWindowTime. The filter delay, (window - 1) / 2 frames, stays below
+maxWindowTime / 2 but it is not the same for every frame rate, e.g. with 115 ms: 36 ms at 18 ms frames,
+45 ms at 22.5 ms, 30 ms at 30 ms and 0 at 45 ms (1 point).
+A single interval of 4 or more frame intervals is a gap and is ignored, after MEDIANFILTER_INTERVAL_RESET_FRAMES
+of them in a row the radio is taken as slower and the interval is measured again.
+The history always keeps the latest 9 frames, so the window can be changed at any time without a glitch.
+
+Warm start: the history is filled with the first valid frame, so the first frames after boot are not
+mixed with DefaultInputValue. It is filled again with the first valid frame after a failsafe condition
+(Ch0 is codeFailSafe, the failsafe frames are passed through) and after a gap of the signal longer than reseedGap.
+
+Fractional output (optional chOUT_Q4[] of ApplyFilter): the trimmed mean of the window in 1/16 us (Q4) -
+the window is sorted, trimPoints values are dropped at each end (the outliers) and the rest is averaged.
+The averaging recovers the sub-microsecond part of a slowly moving stick from the jitter of the samples,
+so the joystick axis moves in steps finer than 1 us. chOUT[] is still the median.
 
 Original idea: https://github.com/iNavFlight/inav/blob/44c494af43b90d8a8fbce7afaad5a3334687d2f4/src/main/common/maths.c#L307
                https://github.com/iNavFlight/inav/blob/master/src/main/rx/rx.c
@@ -33,6 +51,14 @@ included in all copies or substantial portions of the Software.
 
 #include "Arduino.h"
 
+//The largest filter window, points
+#define MEDIANFILTER_MAX_WINDOW 9
+
+//A new window size is used after it has been selected for this many frames in a row 
+#define MEDIANFILTER_WINDOW_SETTLE_FRAMES 8
+
+//The frame interval is measured again after this many intervals in a row of 4 or more frame intervals 
+#define MEDIANFILTER_INTERVAL_RESET_FRAMES 4
 
 class MedianFilter {
 	public:
@@ -54,8 +80,38 @@ class MedianFilter {
 		// parameter chIN[] - an array of input values from receiver, pulse length in us 
 		// parameter chOUT[] - an array of output values with the median filter applied, pulse length in us
 		// function output - chOUT[] array updated  		 
-		void ApplyFilter (uint16_t chIN[0], uint16_t chOUT[0]);
+		// parameter chOUT_Q4[] - optional, an array of output values, the trimmed mean of the window in 1/16 us  
+		void ApplyFilter (uint16_t chIN[0], uint16_t chOUT[0], uint16_t* chOUT_Q4 = NULL);
+
+		//This function applies median filter with the window selected by maxWindowTime
+		// parameter timeStamp - time when the input frame was received, us (PPMReader::GetDataInputTimeStamp())  
+		void ApplyFilter (uint16_t chIN[0], uint16_t chOUT[0], uint32_t timeStamp, uint16_t* chOUT_Q4 = NULL);
+
+		//Values dropped at each end of the sorted window for the trimmed mean of chOUT_Q4[], 
+		//at least one value is kept 
+		uint8_t trimPoints = 1;
 	
+		//The maximum time covered by the filter window (window size * frame interval), us. 
+		//0 - the window is always 5 points 
+		uint32_t maxWindowTime = 0;
+
+		//Returns the window size in use, points
+		uint8_t GetWindowSize();
+
+		//Returns the measured frame interval, us, or 0 if not known yet
+		uint32_t GetFrameInterval();
+
+		//Code in Ch0 for failsafe condition
+		uint16_t codeFailSafe = 0;
+
+		//The history is filled again with the next frame after a gap of the signal longer than this, us, 0 - never
+		uint32_t reseedGap = 100000;
+
+		//The history is filled again with the next valid frame 
+		void Reset();
+
+		//Returns true if the history has been filled with a valid frame 
+		bool IsSeeded();
 	
         //This function passes the input to servos without changes
         // parameter chIN[] - an array of input values from receiver, pulse length in us 
@@ -77,16 +133,26 @@ class MedianFilter {
 		uint32_t _timestamp = 0;
 
 
-		// A set of arrays to hold the historical values for RC channels. 
-	 	int _queuePointer = 1; 	
-		int AA = 1;
-		
-		uint16_t  _queuePosition1[17];	
-		uint16_t  _queuePosition2[17];	
-		uint16_t  _queuePosition3[17];
-		uint16_t  _queuePosition4[17];
-		uint16_t  _queuePosition5[17];
-	 
+		// Historical values for RC channels, a circular buffer of the latest MEDIANFILTER_MAX_WINDOW frames
+		uint16_t  _history[MEDIANFILTER_MAX_WINDOW][17];
+		uint8_t _newest = 0;  //index of the latest frame in _history 
+		bool _seeded = false;  //the history has been filled with a valid frame
+
+		// Window size in use and a new window size waiting to settle 
+		uint8_t _windowSize = 5;
+		uint8_t _candidateWindowSize = 5;
+		uint8_t _candidateFrames = 0;
+
+		// Frame interval measurement
+		uint32_t _lastTimeStamp = 0;
+		uint32_t _frameInterval = 0;
+		uint8_t _longIntervals = 0;  //intervals of 4 or more frame intervals in a row
+
+		//Updates the frame interval and selects the window size 
+		void updateWindowSize(uint32_t timeStamp);
+
+		//Sorts the window values, insertion sort, n <= MEDIANFILTER_MAX_WINDOW
+		static void sortWindow(uint16_t * v, uint8_t n);
 	 
 		//These functions are median filters 
 		// parameter * v - an array of input values,  assume the oldest value has array index as 0 
@@ -96,7 +162,9 @@ class MedianFilter {
 		uint32_t quickMedianFilter5_32(uint32_t * v);
 		uint16_t quickMedianFilter5_16(uint16_t * v);
 		uint32_t quickMedianFilter7_32(uint32_t * v);
+		uint16_t quickMedianFilter7_16(uint16_t * v);
 		uint32_t quickMedianFilter9_32(uint32_t * v);
+		uint16_t quickMedianFilter9_16(uint16_t * v);
 		
 	};
 
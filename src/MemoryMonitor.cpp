@@ -0,0 +1,156 @@
+/*
+Memory monitor
+
+Stack painting, stack pointer samples and the RAM footprint report.
+
+The linker symbols are from the libmaple linker scripts of Arduino_STM32 (common.inc):
+__data_start__ and __bss_end__ limit the static data, the heap starts at the end of .bss,
+__msp_init is the initial stack pointer (the top of the RAM).
+
+TODO - see the .h file
+=================================================================
+(C) 2026 ifh
+This file is part of PPM to USB Joystick.
+
+PPM to USB Joystick is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+PPM to USB Joystick is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+*/
+
+// Set to true to print some debug messages, or false to disable them.
+//#define ENABLE_DEBUG_OUTPUT_MEMORYMONITOR
+
+#include "Arduino.h"
+#include "MemoryMonitor.h"
+
+#ifdef __STM32F1__
+#include <unistd.h>
+
+extern "C" char __data_start__;
+extern "C" char __bss_end__;
+extern "C" char __msp_init;
+#endif
+
+volatile uint32_t MemoryMonitor::_lowestStackPointer[MEMORYMONITOR_CONTEXTS];
+
+
+/* Set MemoryMonitor object */
+MemoryMonitor::MemoryMonitor() {
+	memset(_moduleSize, 0, sizeof(_moduleSize));
+	for (uint8_t i=0; i<MEMORYMONITOR_CONTEXTS; i++) {
+		_lowestStackPointer[i] = 0xFFFFFFFF;
+	}
+}
+
+
+/* Delete MemoryMonitor object */
+MemoryMonitor::~MemoryMonitor() {
+}
+
+
+/* Function to return the end of the heap */
+uint32_t MemoryMonitor::heapEnd() {
+#ifdef __STM32F1__
+	return ((uint32_t)sbrk(0) + 3) & ~3;
+#else
+	return 0;
+#endif
+}
+
+
+/* Function to paint the free stack */
+void MemoryMonitor::begin() {
+#ifdef __STM32F1__
+	_stackTop = (uint32_t)&__msp_init;
+	_staticSize = (uint32_t)&__bss_end__ - (uint32_t)&__data_start__;
+	_heapStart = (uint32_t)&__bss_end__;
+	_paintBottom = heapEnd();
+
+	//Only below the stack of this function
+	uint32_t sp;
+	asm volatile ("mov %0, sp" : "=r" (sp));
+	uint32_t* top = (uint32_t*)(sp - MEMORYMONITOR_PAINT_GUARD);
+	for (uint32_t* p = (uint32_t*)_paintBottom; p < top; ++p) {
+		*p = MEMORYMONITOR_PAINT;
+	}
+#endif
+
+#ifdef ENABLE_DEBUG_OUTPUT_MEMORYMONITOR
+  Serial.print("MemoryMonitor::begin completed, stack area: ");
+  Serial.println(_stackTop - _paintBottom);
+#endif
+}
+
+
+/* Function to set the RAM of a module */
+void MemoryMonitor::setModuleSize(memoryModule module, uint16_t size) {
+	if (module < MEMORYMONITOR_MODULES) {
+		_moduleSize[module] = size;
+	}
+}
+
+
+/* Function to return the stack high-water mark.
+The scan starts above the heap, if the heap has grown into the painted area that part is not stack */
+uint32_t MemoryMonitor::GetStackHighWater() {
+#ifdef __STM32F1__
+	if (_paintBottom == 0) {
+		return 0;
+	}
+	uint32_t bottom = heapEnd();
+	const uint32_t* p = (const uint32_t*)((bottom > _paintBottom) ? bottom : _paintBottom);
+	while ((uint32_t)p < _stackTop && *p == MEMORYMONITOR_PAINT) {
+		++p;
+	}
+	return _stackTop - (uint32_t)p;
+#else
+	return 0;
+#endif
+}
+
+
+/* Function to return the deepest sampled stack of a context */
+uint32_t MemoryMonitor::GetContextDepth(memoryContext context) {
+	uint32_t sp = _lowestStackPointer[context];
+	if (sp == 0xFFFFFFFF || sp > _stackTop) {
+		return 0;
+	}
+	return _stackTop - sp;
+}
+
+
+/* Function to write the feature report */
+uint16_t MemoryMonitor::writeFeatureReport(uint8_t* buffer, uint8_t reportID) {
+	memoryReport_t report;
+	memset(&report, 0, sizeof(report));
+	report.reportID = reportID;
+
+	if (_paintBottom != 0) {
+		uint32_t heap = heapEnd();
+		uint32_t highWater = GetStackHighWater();
+		report.ramSize = _stackTop - MEMORYMONITOR_RAM_START;
+		report.staticSize = _staticSize;
+		report.heapSize = heap - _heapStart;
+		report.stackSize = _stackTop - _paintBottom;
+		report.stackHighWater = highWater;
+		report.freeRam = (_stackTop - heap > highWater) ? _stackTop - heap - highWater : 0;
+	}
+	for (uint8_t i=0; i<MEMORYMONITOR_CONTEXTS; i++) {
+		uint32_t depth = GetContextDepth((memoryContext)i);
+		report.contextDepth[i] = (depth < 0xFFFF) ? depth : 0xFFFF;
+	}
+	memcpy(report.moduleSize, _moduleSize, sizeof(report.moduleSize));
+
+	memcpy(buffer, &report, sizeof(report));
+	return sizeof(report);
+}
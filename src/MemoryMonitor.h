@@ -0,0 +1,157 @@
+/*
+Memory monitor
+
+RAM and stack budget of the firmware, readable over USB as a feature report:
+ - stack painting: begin() fills the free RAM between the heap and the stack with a pattern,
+   the lowest word which is not the pattern any more is the stack high-water mark
+   (all contexts share the main stack, so it includes the interrupts)
+ - stack pointer samples: sampleStack() records the lowest stack pointer seen in a context
+   (the main loop, the PPM edge interrupts, the watchdog timer interrupt, the PPM output DMA interrupt,
+   the pipeline software interrupt), the depth is from the top of the RAM.
+   The sample is the stack pointer where sampleStack() is called (the loop() or the hook at the entry of
+   an interrupt), the calls below it are not included, so the depth of a context is a lower bound;
+   the painted high-water mark is the upper bound of all contexts together.
+   The libraries do not call it: the sketch samples the loop() and the pipeline, and the interrupts
+   through the PPMReader/PPMWriter hooks (ENABLE_STACK_SAMPLES in the sketch, off by default as it is a call per edge)
+ - static data (.data + .bss) and heap size from the linker symbols and sbrk()
+ - RAM size of the modules (sizeof of their objects and buffers), set by the sketch with setModuleSize()
+
+The flash and RAM of every object file (including the USB composite stack and the core) come from the
+linker map, see extras/tools/memory_map.py.
+
+Feature report layout (little endian, packed, sizes in bytes):
+  byte 0       - report ID
+  bytes 1..2   - RAM size
+  bytes 3..4   - static data, .data + .bss
+  bytes 5..6   - heap
+  bytes 7..8   - stack area, from the heap end to the top of the RAM at begin()
+  bytes 9..10  - stack high-water mark (painted)
+  bytes 11..12 - free RAM, the stack area not reached yet
+  bytes 13..22 - stack depth of each context: main loop, PPM edge interrupts, watchdog timer interrupt,
+                 pipeline software interrupt, PPM output DMA interrupt (sampled, a lower bound, 0 - not sampled)
+  bytes 23..42 - RAM of each module, see memoryModule
+The painting, the symbols and the stack pointer samples are STM32 only, elsewhere they are 0.
+
+TODO:
+- sample the USB interrupt context
+
+=================================================================
+(C) 2026 ifh
+This file is part of PPM to USB Joystick.
+
+PPM to USB Joystick is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+PPM to USB Joystick is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+*/
+
+#ifndef MEMORYMONITOR_H
+#define MEMORYMONITOR_H
+
+#include "Arduino.h"
+
+//Start of the RAM and the pattern of the free stack
+#define MEMORYMONITOR_RAM_START 0x20000000
+#define MEMORYMONITOR_PAINT 0xA5A5A5A5
+//Bytes below the stack pointer of begin() which are not painted
+#define MEMORYMONITOR_PAINT_GUARD 64
+
+//Contexts of the stack pointer samples
+typedef enum memoryContext {
+    MEMORY_CONTEXT_LOOP = 0,
+    MEMORY_CONTEXT_PPM_ISR = 1,
+    MEMORY_CONTEXT_TIMER_ISR = 2,   //the signal loss watchdog
+    MEMORY_CONTEXT_PIPELINE = 3,
+    MEMORY_CONTEXT_DMA_ISR = 4      //the PPM output
+} memoryContext;
+#define MEMORYMONITOR_CONTEXTS 5
+
+//Modules in the footprint report
+typedef enum memoryModule {
+    MEMORY_MODULE_PPMREADER = 0,
+    MEMORY_MODULE_MEDIANFILTER = 1,
+    MEMORY_MODULE_CALIBRATION = 2,
+    MEMORY_MODULE_MAPPER = 3,
+    MEMORY_MODULE_STATS = 4,
+    MEMORY_MODULE_JOYSTICKREPORT = 5,
+    MEMORY_MODULE_PPMWRITER = 6,
+    MEMORY_MODULE_PPMMERGER = 7,
+    MEMORY_MODULE_USB = 8,
+    MEMORY_MODULE_SKETCH = 9
+} memoryModule;
+#define MEMORYMONITOR_MODULES 10
+
+//Feature report
+typedef struct {
+    uint8_t reportID;
+    uint16_t ramSize;
+    uint16_t staticSize;
+    uint16_t heapSize;
+    uint16_t stackSize;
+    uint16_t stackHighWater;
+    uint16_t freeRam;
+    uint16_t contextDepth[MEMORYMONITOR_CONTEXTS];
+    uint16_t moduleSize[MEMORYMONITOR_MODULES];
+} __attribute__((packed)) memoryReport_t;
+
+
+class MemoryMonitor {
+	public:
+		//Set MemoryMonitor object
+		MemoryMonitor();
+
+		//Delete MemoryMonitor object
+		~MemoryMonitor();
+
+		//Paints the free stack, call it first in setup()
+		void begin();
+
+		//Sets the RAM of a module, bytes
+		void setModuleSize(memoryModule module, uint16_t size);
+
+		//Records the stack pointer in a context, cheap enough for the interrupts
+		static inline void sampleStack(memoryContext context) {
+#ifdef __STM32F1__
+			uint32_t sp;
+			asm volatile ("mov %0, sp" : "=r" (sp));
+			if (sp < _lowestStackPointer[context]) {
+				_lowestStackPointer[context] = sp;
+			}
+#else
+			(void)context;
+#endif
+		}
+
+		//Returns the stack high-water mark (bytes used), scans the painted area
+		uint32_t GetStackHighWater();
+
+		//Returns the deepest sampled stack of a context, bytes, 0 - not sampled. A lower bound, see above
+		uint32_t GetContextDepth(memoryContext context);
+
+		//Writes the feature report into a buffer of at least sizeof(memoryReport_t) bytes. Returns the report size.
+		uint16_t writeFeatureReport(uint8_t* buffer, uint8_t reportID);
+
+	private:
+		//Top of the stack and the painted area
+		uint32_t _stackTop = 0;
+		uint32_t _paintBottom = 0;
+		uint32_t _staticSize = 0;
+		uint32_t _heapStart = 0;
+		uint16_t _moduleSize[MEMORYMONITOR_MODULES];
+
+		static volatile uint32_t _lowestStackPointer[MEMORYMONITOR_CONTEXTS];
+
+		//Returns the end of the heap
+		static uint32_t heapEnd();
+};
+
+#endif
@@ -0,0 +1,177 @@
+/*
+PPM Merger
+
+Merges frames from several PPMReader instances (trainer / buddy-box setup) into a single frame.
+
+TODO - see the .h file
+=================================================================
+(C) 2026 ifh
+This file is part of PPM to USB Joystick.
+
+PPM to USB Joystick is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+PPM to USB Joystick is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+*/
+
+// Set to true to print some debug messages, or false to disable them.
+//#define ENABLE_DEBUG_OUTPUT_MERGER
+
+#include "Arduino.h"
+#include "PPMMerger.h"
+
+
+/* Set PPMMerger object */
+PPMMerger::PPMMerger() {
+	for (uint8_t k=0; k<PPMMERGER_MAX_INPUTS; k++) {
+		_inputs[k]=NULL;
+		_timeStamps[k]=0;
+		for (uint8_t i=0; i<=PPMMERGER_MAX_CHANNELS; i++) {
+			_frames[k][i]=0;
+		}
+	}
+
+	//By default all channels are taken from the input 0
+	for (uint8_t i=0; i<=PPMMERGER_MAX_CHANNELS; i++) {
+		_rules[i].input=0;
+		_rules[i].overrideInput=0;
+		_activeInputs[i]=0;
+	}
+}
+
+
+/* Delete PPMMerger object */
+PPMMerger::~PPMMerger() {
+}
+
+
+/* Function to add an input. Returns the input index or -1 if there are too many inputs 
+or the reader has more channels than a frame buffer holds */
+int8_t PPMMerger::addInput(PPMReader* reader) {
+	if (_inputAmount >= PPMMERGER_MAX_INPUTS || reader == NULL || reader->GetChannelAmount() > PPMMERGER_MAX_CHANNELS) {
+		return -1;
+	}
+	_inputs[_inputAmount]=reader;
+	++_inputAmount;
+
+#ifdef ENABLE_DEBUG_OUTPUT_MERGER
+  Serial.println("PPMMerger::addInput completed");
+#endif
+	return _inputAmount - 1;
+}
+
+
+/* Function to set the source inputs for a channel */
+void PPMMerger::setChannelRule(uint8_t channel, uint8_t input, uint8_t overrideInput) {
+	if (channel == 0 || channel > PPMMERGER_MAX_CHANNELS) {
+		return;
+	}
+	_rules[channel].input = (input < PPMMERGER_MAX_INPUTS) ? input : 0;
+	_rules[channel].overrideInput = (overrideInput < PPMMERGER_MAX_INPUTS) ? overrideInput : 0;
+}
+
+
+/* Function to read all inputs and merge them into an array.
+Returns a timestamp in microseconds of the pacing input frame or 0 if there is no new data.
+Channels is an array from 0 to ChannelAmount+1 to cover the number  of channels from 1 to ChannelAmount */
+uint32_t PPMMerger::readMerged(uint16_t* channels) {
+
+	//Collect the latest frames, remember which inputs have got a new one.
+	//An input is read only if its timestamp has changed, otherwise its last frame is kept
+	uint8_t updatedInputs = 0;
+	for (uint8_t k=0; k<_inputAmount; k++) {
+		uint32_t timeStamp = _inputs[k]->GetDataInputTimeStamp();
+		if (timeStamp == 0 || timeStamp == _timeStamps[k]) {
+			continue;
+		}
+		timeStamp = _inputs[k]->readNormalisedInteger(&_frames[k][0]);
+		if (timeStamp != 0 && timeStamp != _timeStamps[k]) {
+			_timeStamps[k] = timeStamp;
+			updatedInputs |= (1 << k);
+		}
+	}
+
+	if (updatedInputs == 0) { //nothing new, no need to check the rest
+		return 0;
+	}
+
+	//Find healthy inputs: a recent frame and no failsafe
+	uint32_t now = micros();
+	uint8_t healthyInputs = 0;
+	for (uint8_t k=0; k<_inputAmount; k++) {
+		if (_timeStamps[k] != 0 && (now - _timeStamps[k]) <= inputTimeout && _frames[k][0] != codeFailSafe) {
+			healthyInputs |= (1 << k);
+		}
+	}
+
+	//The highest priority healthy input paces the output and takes over failed inputs.
+	//If none of the inputs is healthy then the input 0 paces the failsafe frames.
+	uint8_t pacingInput = 0;
+	if (healthyInputs != 0) {
+		while ((healthyInputs & (1 << pacingInput)) == 0) {
+			++pacingInput;
+		}
+	}
+
+	//Produce a frame only when the pacing input has got a new one
+	if ((updatedInputs & (1 << pacingInput)) == 0) {
+		return 0;
+	}
+
+	//Check the override switch, an input or a channel out of range disables it
+	bool overrideOn = overrideSwitchChannel != 0 && overrideSwitchChannel <= PPMMERGER_MAX_CHANNELS
+	                  && overrideSwitchInput < _inputAmount
+	                  && (healthyInputs & (1 << overrideSwitchInput)) != 0
+	                  && _frames[overrideSwitchInput][overrideSwitchChannel] > overrideSwitchThreshold;
+
+	//Merge the channels
+	uint8_t amount = (channelAmount < PPMMERGER_MAX_CHANNELS) ? channelAmount : PPMMERGER_MAX_CHANNELS;
+	for (uint8_t i=1; i<=amount; i++) {
+		uint8_t input = overrideOn ? _rules[i].overrideInput : _rules[i].input;
+		if ((healthyInputs & (1 << input)) == 0) {
+			input = pacingInput;
+		}
+		_activeInputs[i] = input;
+		channels[i] = _frames[input][i];
+	}
+
+	// Set fail safe value to Channel 0
+	if (healthyInputs == 0) {
+		channels[0]=codeFailSafe;
+	}
+	else
+	{
+		channels[0]=codeNotFailSafe;
+	}
+	_healthyInputs = healthyInputs;
+
+#ifdef ENABLE_DEBUG_OUTPUT_MERGER
+  Serial.print("PPMMerger::readMerged healthy inputs: ");
+  Serial.println(healthyInputs);
+#endif
+	return _timeStamps[pacingInput];
+}
+
+
+/* Function to return the input used for a channel in the latest merged frame */
+uint8_t PPMMerger::GetActiveInput(uint8_t channel) {
+	if (channel > PPMMERGER_MAX_CHANNELS) {
+		return 0;
+	}
+	return _activeInputs[channel];
+}
+
+
+/* Function to return a bit mask of the healthy inputs in the latest merged frame */
+uint8_t PPMMerger::GetHealthyInputs() {
+	return _healthyInputs;
+}
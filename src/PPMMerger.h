@@ -0,0 +1,132 @@
+/*
+PPM Merger
+
+Merges frames from several PPMReader instances (trainer / buddy-box setup) into a single frame.
+Every input keeps its latest complete frame and the time it was received,
+so inputs running at different frame rates are aligned by timestamp (sample-and-hold).
+An input is considered healthy if its latest frame is not older than inputTimeout
+and it is not in a failsafe condition.
+
+For each output channel a rule selects the source input:
+ - normally the channel is taken from the rule's input
+ - while the override switch is on, the channel is taken from the rule's overrideInput
+ - if the selected input is not healthy, the channel is taken from the healthiest input
+   with the highest priority (the lowest index), i.e. takeover on failsafe
+
+A new merged frame is produced only when the pacing input (the highest priority healthy input)
+delivers a new frame, so the output frame rate stays the same as for a single input.
+The merge cost is fixed: one timestamp check per input, one read of an input only when it has
+a new frame (the normalisation toggles the interrupts per channel), plus one table lookup per channel.
+
+Example - instructor on input 0, student on input 1, the student flies while
+the instructor holds the trainer switch on Ch5, the instructor keeps the throttle:
+  Merger.addInput(&ppm);          //input 0
+  Merger.addInput(&ppmTrainer);   //input 1
+  for (uint8_t i=1; i<=8; i++) { Merger.setChannelRule(i, 0, 1); }
+  Merger.setChannelRule(3, 0, 0);
+  Merger.overrideSwitchInput = 0;
+  Merger.overrideSwitchChannel = 5;
+
+TODO:
+
+=================================================================
+(C) 2026 ifh
+This file is part of PPM to USB Joystick.
+
+PPM to USB Joystick is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+PPM to USB Joystick is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+*/
+
+#ifndef PPMMERGER_H
+#define PPMMERGER_H
+
+#include "Arduino.h"
+#include "PPMReader.h"
+
+//The maximum number of inputs and channels supported
+#define PPMMERGER_MAX_INPUTS 4
+#define PPMMERGER_MAX_CHANNELS 16
+
+//Source selection rule for an output channel
+typedef struct mergeRule {
+    uint8_t input;          //input which drives the channel normally
+    uint8_t overrideInput;  //input which drives the channel while the override switch is on
+} mergeRule;
+
+
+class PPMMerger {
+	public:
+		//Set PPMMerger object
+		PPMMerger();
+
+		//Delete PPMMerger object
+		~PPMMerger();
+
+		//The amount of channels to be merged, only PPMMERGER_MAX_CHANNELS are merged if it is more
+		uint8_t channelAmount = 8;
+
+		//Maximum age of the latest frame of an input, microseconds.
+		//An input with an older frame is considered lost.
+		uint32_t inputTimeout = 100000;
+
+		//Override switch - while the channel overrideSwitchChannel of the input overrideSwitchInput
+		//is above overrideSwitchThreshold the rules' overrideInput is used.
+		//overrideSwitchChannel = 0 disables the override switch, so does an input which is not added
+		//or a channel above PPMMERGER_MAX_CHANNELS.
+		uint8_t overrideSwitchInput = 0;
+		uint8_t overrideSwitchChannel = 0;
+		uint16_t overrideSwitchThreshold = 1500;
+
+		//Codes in Ch0 for failsafe condition, shall be the same as for the inputs
+		uint16_t codeFailSafe=0;
+		uint16_t codeNotFailSafe=3;
+
+		//Adds an input. Inputs added first have a higher priority for failsafe takeover.
+		//Returns the input index, or -1 if there are too many inputs or the reader has more channels
+		//than PPMMERGER_MAX_CHANNELS (its frames are read into a buffer of that size)
+		int8_t addInput(PPMReader* reader);
+
+		//Sets the source inputs for a channel (1..channelAmount)
+		void setChannelRule(uint8_t channel, uint8_t input, uint8_t overrideInput);
+
+		//Reads all inputs and merges them into an array.
+		//Returns a timestamp in microseconds of the pacing input frame,
+		//or 0 if there is no new data.
+		//channels is an array from 0 to ChannelAmount+1 to cover the number of channels from 1 to ChannelAmount,
+		//Ch0 is codeFailSafe if none of the inputs is healthy.
+		uint32_t readMerged(uint16_t* channels);
+
+		//Returns the input used for a channel in the latest merged frame
+		uint8_t GetActiveInput(uint8_t channel);
+
+		//Returns a bit mask of the inputs which were healthy in the latest merged frame
+		uint8_t GetHealthyInputs();
+
+	private:
+		PPMReader* _inputs[PPMMERGER_MAX_INPUTS];
+		uint8_t _inputAmount = 0;
+
+		//The latest frame and its timestamp for each input
+		uint16_t _frames[PPMMERGER_MAX_INPUTS][PPMMERGER_MAX_CHANNELS + 1];
+		uint32_t _timeStamps[PPMMERGER_MAX_INPUTS];
+
+		//Source selection rules and the latest selection, indexed {1..channelAmount}
+		mergeRule _rules[PPMMERGER_MAX_CHANNELS + 1];
+		uint8_t _activeInputs[PPMMERGER_MAX_CHANNELS + 1];
+
+		uint8_t _healthyInputs = 0;
+
+};
+
+#endif
@@ -1,6 +1,24 @@
 /*
 Original library is from https://github.com/Nikkilae/PPM-reader
 Updated by IF 
+2026-10-19
+- applySignalLoss() holds the channels and marks the frame, the sketch applies signalLossPolicy, IsSignalLost()
+- writeDiagnostics()
+- applySignalLoss(), called by decodeEdges() with deferred decoding instead of the watchdog interrupt
+- edgeHook and watchdogHook, the library no longer depends on MemoryMonitor
+- readLevel(): the level of an edge from the GPIO input register
+- profile fields const with RADIO_PROFILE_STATIC, which is opt-in
+- GetChannelAmount()
+- frame queue filled where the frames complete (processPulse(), onSignalLoss()) and taken by readFrame()
+- deferred decoding: edge time queue filled by ISR and decoded by decodeEdges(), setInterruptPriority(),
+  dataInputTimeStamp is the time of the last edge of the frame instead of micros() in ISR
+- stack pointer samples for the memory monitor in the edge and watchdog interrupts,
+  constructor no longer writes past the end of rawValues
+- dual-edge capture with the polarity detection and edge-averaged channel timing, setupInterrupt() switch fall-through fixed
+- signal loss watchdog: TIMER4 is restarted by every edge and times out after signalLossFrames frame periods
+- count complete frames and rejected pulses in ISR
+- limits, failsafe window and calibration multipliers from the compile time radio profile (RADIO_PROFILE_STATIC),
+  integer only normalisation when the profile scale is 1.0
 2022-02-23
 - removed unnecessary comparison 
 2021-03-05
@@ -41,6 +59,47 @@ along with PPM Reader.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "PPMReader.h"
 
+#ifdef __STM32F1__
+#include <libmaple/timer.h>
+#include <libmaple/nvic.h>
+#include <libmaple/gpio.h>
+#endif
+
+//The compiler must not move memory accesses across it: a queued frame is written before the head 
+//moves and read before the tail moves (a single core, so no hardware barrier is needed)
+#define PPMREADER_COMPILER_BARRIER() asm volatile ("" : : : "memory")
+
+//The timer interrupt handler has no argument, so only one PPMReader can use the watchdog
+static PPMReader* watchdogPPMReader = NULL;
+
+#ifdef __STM32F1__
+static void watchdogHandler() {
+	if (watchdogPPMReader != NULL) {
+		watchdogPPMReader->onSignalLoss();
+	}
+}
+#endif
+
+//Parameters used by the ISR and the read functions - either compile time constants
+//from the radio profile or the run time fields of PPMReader
+#ifdef RADIO_PROFILE_STATIC
+  #define PPM_MIN_CHANNEL_VALUE   activeRadio.minChannelValue
+  #define PPM_MAX_CHANNEL_VALUE   activeRadio.maxChannelValue
+  #define PPM_BLANK_TIME          activeRadio.blankTime
+  #define PPM_MULTIPLIER_SCALE    activeRadio.multiplierScale
+  #define PPM_MULTIPLIER_BIAS     activeRadio.multiplierBias
+  #define PPM_FAILSAFE_MIN_PULSE  activeRadio.failSafeMinPulseLength
+  #define PPM_FAILSAFE_MAX_PULSE  activeRadio.failSafeMaxPulseLength
+#else
+  #define PPM_MIN_CHANNEL_VALUE   minChannelValue
+  #define PPM_MAX_CHANNEL_VALUE   maxChannelValue
+  #define PPM_BLANK_TIME          blankTime
+  #define PPM_MULTIPLIER_SCALE    multiplierScale
+  #define PPM_MULTIPLIER_BIAS     multiplierBias
+  #define PPM_FAILSAFE_MIN_PULSE  failSafeMinPulseLength
+  #define PPM_FAILSAFE_MAX_PULSE  failSafeMaxPulseLength
+#endif
+
 /* Set PMReader object */
 PPMReader::PPMReader(uint8_t channelAmount) {
 #ifdef ENABLE_DEBUG_OUTPUT_PPMReader
@@ -56,7 +115,7 @@ PPMReader::PPMReader(uint8_t channelAmount) {
         //validValues = new uint16_t[channelAmount];
         rawValues = new uint16_t[channelAmount + 1];
 		
-        for (uint8_t i = 0; i <= channelAmount + 1 ; ++i) {
+        for (uint8_t i = 0; i <= channelAmount; ++i) {
             rawValues[i] = 0;
 
         }
@@ -77,17 +136,33 @@ PPMReader::~PPMReader() {
 }
 
 /* Function to setup interrupt */
-void PPMReader::setupInterrupt(uint8_t pin, signalPolarity PPMsignalPolarity)
+void PPMReader::setupInterrupt(uint8_t pin, signalPolarity PPMsignalPolarity, bool dualEdge)
 {
-  ExtIntTriggerMode mode;
+  ExtIntTriggerMode mode = FALLING;
   interruptPin=pin;
+#ifdef __STM32F1__
+  levelRegister = &PIN_MAP[pin].gpio_device->regs->IDR;
+  levelMask = 1UL << PIN_MAP[pin].gpio_bit;
+#endif
   
   //attach interrupt as per the signal polarity
    switch (PPMsignalPolarity) {
     case NORMAL:
         mode = RISING;
+        activeLevel = HIGH;
+        break;
     case INVERTED:
         mode = FALLING;
+        activeLevel = LOW;
+        break;
+    case AUTO:
+        activeLevel = PPMREADER_LEVEL_UNKNOWN;
+        dualEdge = true;
+        break;
+   }
+   this->dualEdge = dualEdge;
+   if (dualEdge) {
+        mode = CHANGE;
    }
    
   attachInterrupt(pin, myIsrTrampoline, this, mode);
@@ -97,23 +172,159 @@ void PPMReader::setupInterrupt(uint8_t pin, signalPolarity PPMsignalPolarity)
 #endif
 }
 
+/* Function to return the level of the pin. On STM32 the port input register is read directly,
+a few cycles instead of the pin lookup of digitalRead(), so the level is read as close to the edge as possible. 
+It is still the level after the interrupt entry latency, see minSeparatorWidth */
+inline uint8_t PPMReader::readLevel() {
+#ifdef __STM32F1__
+	return (*levelRegister & levelMask) ? HIGH : LOW;
+#else
+	return digitalRead(interruptPin) ? HIGH : LOW;
+#endif
+}
+
+
 /* Interrupt Service Routine */
 void PPMReader::ISR() {  
 //just to check that ISR is called - it  is a bad practice to debug ISR with serial print!
 #ifdef ENABLE_DEBUG_OUTPUT_PPMReader
   Serial.println("PPMReader::ISR() called"); 
 #endif
+    if (edgeHook != NULL) {
+        edgeHook();
+    }
 
   // Remember the current micros() and calculate the time since the last pulseReceived()
     uint32_t previousMicros = microsAtLastPulse;
     microsAtLastPulse = micros();
-    uint16_t time = microsAtLastPulse - previousMicros;
-    
-    if (time > blankTime) {
+
+    //Restart the signal loss watchdog 
+    if (watchdogRunning) {
+#ifdef __STM32F1__
+        TIMER4->regs.gen->CNT = 0;
+        TIMER4->regs.gen->CR1 |= TIMER_CR1_CEN;
+#endif
+        watchdogArmed = true;
+    }
+
+    //Deferred decoding - queue the edge, if the queue is full the edge is lost and decodeEdges() drops the frame
+    if (deferredDecode) {
+        uint8_t head = edgeHead;
+        if ((uint8_t)(head - edgeTail) >= PPMREADER_EDGE_QUEUE_SIZE) {
+            //the gap is before the next edge which gets into the queue
+            if (!edgeOverflow) {
+                edgeGap = head;
+                edgeOverflow = true;
+            }
+            ++edgeOverflowCount;
+        }
+        else
+        {
+            edgeTimes[head % PPMREADER_EDGE_QUEUE_SIZE] = microsAtLastPulse;
+            if (dualEdge) {
+                edgeLevels[head % PPMREADER_EDGE_QUEUE_SIZE] = readLevel();
+            }
+            edgeHead = head + 1;
+        }
+        decodeRequest();
+        return;
+    }
+
+    if (dualEdge) {
+        captureEdge(microsAtLastPulse, readLevel());
+        return;
+    }
+    processPulse(microsAtLastPulse - previousMicros, microsAtLastPulse);
+}
+
+
+/* Function to set up deferred decoding */
+void PPMReader::setupDeferredDecode(void (*decodeRequest)()) {
+	noInterrupts();
+	this->decodeRequest = decodeRequest;
+	decodedEdgeTime = microsAtLastPulse;
+	edgeTail = edgeHead;
+	deferredDecode = (decodeRequest != NULL);
+	interrupts();
+
+#ifdef ENABLE_DEBUG_OUTPUT_PPMReader
+  Serial.println("PPMReader::setupDeferredDecode completed"); 
+#endif
+}
+
+
+/* Function to decode the queued edges. Only this function moves the tail of the queue.
+A signal loss queued by the watchdog is applied after the edges before it */
+void PPMReader::decodeEdges() {
+	uint8_t tail = edgeTail;
+	while (tail != edgeHead) {
+		if (signalLossTail != signalLossHead
+		    && (int32_t)(edgeTimes[tail % PPMREADER_EDGE_QUEUE_SIZE] - signalLossTime) > 0) {
+			signalLossTail = signalLossHead;
+			applySignalLoss(signalLossTime);
+		}
+		if (edgeOverflow && tail == edgeGap) {
+			//edges are missing here, the frame in progress is dropped and the next frame starts after a blank time 
+			edgeOverflow = false;
+			pulseCounter = channelAmount;
+			separatorStarted = false;
+		}
+		uint32_t timeStamp = edgeTimes[tail % PPMREADER_EDGE_QUEUE_SIZE];
+		if (dualEdge) {
+			captureEdge(timeStamp, edgeLevels[tail % PPMREADER_EDGE_QUEUE_SIZE]);
+		}
+		else
+		{
+			processPulse(timeStamp - decodedEdgeTime, timeStamp);
+		}
+		decodedEdgeTime = timeStamp;
+		edgeTail = ++tail;
+	}
+	if (signalLossTail != signalLossHead) {
+		signalLossTail = signalLossHead;
+		applySignalLoss(signalLossTime);
+	}
+}
+
+
+/* Function to return the number of edges lost because the queue was full */
+uint32_t PPMReader::GetEdgeOverflowCount() {
+	return this->edgeOverflowCount;
+}
+
+
+/* Function to set the priority of the edge interrupt and of the watchdog timer interrupt.
+The EXTI line of a pin is its bit number in the port, lines 5..9 and 10..15 share an interrupt */
+void PPMReader::setInterruptPriority(uint8_t priority) {
+#ifdef __STM32F1__
+	uint8_t line = PIN_MAP[interruptPin].gpio_bit;
+	nvic_irq_num irq = NVIC_EXTI_15_10;
+	if (line < 5) {
+		irq = (nvic_irq_num)(NVIC_EXTI0 + line);
+	}
+	else if (line < 10) {
+		irq = NVIC_EXTI_9_5;
+	}
+	nvic_irq_set_priority(irq, priority);
+	if (watchdogRunning) {
+		nvic_irq_set_priority(NVIC_TIMER4, priority);
+	}
+#else
+	(void)priority;
+#endif
+}
+
+
+/* Function to handle the time between two separators, called from ISR or decodeEdges().
+timeStamp is the time of the edge which ends the pulse */
+void PPMReader::processPulse(uint16_t time, uint32_t timeStamp) {
+    if (time > PPM_BLANK_TIME) {
         /* If the time between pulses was long enough to be considered an end
          * of a signal frame, prepare to read channel values from the next pulses */
         pulseCounter = 0;
 		failSafe=false;
+		signalLost = false;
+        updateFramePeriod(timeStamp);
     }
     else {
             //Proceed only if a captured impulse looks valid - 
@@ -121,7 +332,7 @@ void PPMReader::ISR() {
             //missing or multiple interrupt firing etc. so the rest of 
             //the logic is not disturbed.   
             //Otherwise simply ignore detected impulses that are too short or too long 
-            if (time >= minChannelValue && time <= maxChannelValue)  {  
+            if (time >= PPM_MIN_CHANNEL_VALUE && time <= PPM_MAX_CHANNEL_VALUE)  {  
 
                 // Set DataReady flag  to 0 as the data is being acquired AND
                 //Store times between pulses as channel values
@@ -130,7 +341,7 @@ void PPMReader::ISR() {
                     dataInputTimeStamp=0;
                     rawValues[pulseCounter+1] = time;  // pulseCounter+1 is for change {0..15} to {1.16}
                     //Check if value are in failsafe  range (Walkera DEVO 12E returns 800 us approx)
-                    if (time >= failSafeMinPulseLength && time <= failSafeMaxPulseLength) {
+                    if (time >= PPM_FAILSAFE_MIN_PULSE && time <= PPM_FAILSAFE_MAX_PULSE) {
                         failSafe=true;
                     }
                 }
@@ -139,14 +350,206 @@ void PPMReader::ISR() {
 				// if all pulses counted then set flag that data is ready 
                 if (pulseCounter==channelAmount) {
                     isDataReady=true;
-                    dataInputTimeStamp=micros();
+                    dataInputTimeStamp=timeStamp;
+                    ++frameCount;
+                    enqueueFrame(timeStamp);
                 }
 		}
+		else
+		{
+			++rejectedPulseCount;
+		}
 	}
+}
 
-	
+
+/* Function to handle an edge in the dual-edge capture mode, called from ISR or decodeEdges().
+A channel is the average of the leading edge to leading edge and the trailing edge to trailing edge times, 
+so the latency jitter of the two interrupts is averaged */
+void PPMReader::captureEdge(uint32_t timeStamp, uint8_t level) {
+	if (activeLevel == PPMREADER_LEVEL_UNKNOWN) {
+		detectPolarity(timeStamp, level);
+		return;
+	}
+
+	if (level == activeLevel) {
+		//Leading edge of a separator pulse
+		leadingEdgeTime = timeStamp;
+		separatorStarted = true;
+		return;
+	}
+	//Trailing edge, ignored if the leading edge was missed
+	if (!separatorStarted) {
+		return;
+	}
+	separatorStarted = false;
+
+	//A spike is not a separator, the channel goes on 
+	uint32_t width = timeStamp - leadingEdgeTime;
+	if (width < minSeparatorWidth || width > maxSeparatorWidth) {
+		++rejectedPulseCount;
+		return;
+	}
+
+	uint32_t time = ((leadingEdgeTime - lastLeadingEdgeTime) + (timeStamp - lastTrailingEdgeTime) + 1) / 2;
+	lastLeadingEdgeTime = leadingEdgeTime;
+	lastTrailingEdgeTime = timeStamp;
+	processPulse((time < 0xFFFF) ? time : 0xFFFF, timeStamp);
+}
+
+
+/* Function to measure the time at each level until the active level is known, called from ISR.
+The separator pulses are short, so the signal is at the active level for the shorter time */
+void PPMReader::detectPolarity(uint32_t timeStamp, uint8_t level) {
+	if (polarityEdges > 0) {
+		uint32_t interval = timeStamp - polarityEdgeTime;
+		//the signal was at the other level before this edge
+		if (level == HIGH) {
+			lowTime += interval;
+		}
+		else
+		{
+			highTime += interval;
+		}
+	}
+	polarityEdgeTime = timeStamp;
+
+	if (++polarityEdges >= PPMREADER_POLARITY_DETECT_EDGES) {
+		activeLevel = (highTime < lowTime) ? HIGH : LOW;
+		separatorStarted = false;
+
+#ifdef ENABLE_DEBUG_OUTPUT_PPMReader
+  Serial.println("PPMReader::detectPolarity completed"); 
+#endif
+	}
 }
 
+
+/* Function to return the signal polarity, AUTO until it is detected */
+signalPolarity PPMReader::GetPolarity() {
+	if (activeLevel == PPMREADER_LEVEL_UNKNOWN) {
+		return AUTO;
+	}
+	return (activeLevel == HIGH) ? NORMAL : INVERTED;
+}
+
+/* Function to update the frame period and the watchdog timeout at the start of a frame, called from ISR or decodeEdges() */
+void PPMReader::updateFramePeriod(uint32_t timeStamp) {
+	uint32_t interval = timeStamp - frameStartTimeStamp;
+	bool first = (frameStartTimeStamp == 0);
+	frameStartTimeStamp = timeStamp;
+	if (first || !watchdogRunning) {
+		return;
+	}
+
+	//Smooth the period, ignore gaps (e.g. after a lost signal)
+	if (framePeriod == 0) {
+		framePeriod = interval;
+	}
+	else if (interval < 2 * framePeriod) {
+		framePeriod = framePeriod + ((int32_t)(interval - framePeriod) / 8);
+	}
+
+	uint32_t timeout = signalLossFrames * framePeriod;
+	if (timeout > PPMREADER_WATCHDOG_MAX_TIMEOUT) {
+		timeout = PPMREADER_WATCHDOG_MAX_TIMEOUT;
+	}
+	if (timeout != signalLossTimeout) {
+		signalLossTimeout = timeout;
+#ifdef __STM32F1__
+		timer_set_reload(TIMER4, timeout);
+#endif
+	}
+}
+
+
+/* Function to set up the signal loss watchdog */
+void PPMReader::setupSignalLossWatchdog() {
+	uint32_t timeout = signalLossFrames * defaultFramePeriod;
+	signalLossTimeout = (timeout < PPMREADER_WATCHDOG_MAX_TIMEOUT) ? timeout : PPMREADER_WATCHDOG_MAX_TIMEOUT;
+	watchdogPPMReader = this;
+
+#ifdef __STM32F1__
+	//One pulse mode: the counter stops at the timeout, the next edge clears and starts it again.
+	//Only an overflow makes the update interrupt (URS), not the update generated here.
+	timer_dev* dev = TIMER4;
+	timer_pause(dev);
+	timer_set_prescaler(dev, CYCLES_PER_MICROSECOND - 1);  //1 us tick
+	timer_set_reload(dev, signalLossTimeout);
+	dev->regs.gen->CR1 |= TIMER_CR1_OPM | TIMER_CR1_URS;
+	timer_generate_update(dev);
+	timer_set_count(dev, 0);
+	timer_attach_interrupt(dev, TIMER_UPDATE_INTERRUPT, watchdogHandler);
+#endif
+	watchdogRunning = true;
+
+#ifdef ENABLE_DEBUG_OUTPUT_PPMReader
+  Serial.println("PPMReader::setupSignalLossWatchdog completed"); 
+#endif
+}
+
+
+/* Watchdog timeout event, called from the timer interrupt. 
+Once per loss - the next edge arms the watchdog again.
+With deferred decoding the loss is only queued, decodeEdges() applies it */
+void PPMReader::onSignalLoss() {
+	if (watchdogHook != NULL) {
+		watchdogHook();
+	}
+	if (!watchdogArmed) {
+		return;
+	}
+	watchdogArmed = false;
+
+	uint32_t now = micros();
+	signalLossDetectionTime = now - microsAtLastPulse;
+	++signalLossCount;
+
+	if (deferredDecode) {
+		signalLossTime = now;
+		PPMREADER_COMPILER_BARRIER();
+		signalLossHead = signalLossHead + 1;
+		decodeRequest();
+		return;
+	}
+	applySignalLoss(now);
+}
+
+
+/* Function to drop the frame in progress and make the failsafe frame ready, 
+called from the watchdog interrupt or decodeEdges(). The last values are held and the frame is marked 
+as a signal loss: signalLossPolicy is applied by the sketch at the calibrated values, a raw value set here 
+would be moved by the normalisation and the calibration */
+void PPMReader::applySignalLoss(uint32_t timeStamp) {
+	//A frame in progress is dropped, the next frame starts after a blank time 
+	pulseCounter = channelAmount;
+	failSafe = true;
+	signalLost = true;
+	isDataReady = true;
+	dataInputTimeStamp = timeStamp;
+	enqueueFrame(timeStamp);
+}
+
+
+/* Function to return the time when the watchdog times out, or 0 if it is not armed */
+uint32_t PPMReader::GetSignalLossDeadline() {
+	if (!watchdogRunning || !watchdogArmed) {
+		return 0;
+	}
+	return microsAtLastPulse + signalLossTimeout;
+}
+
+/* Function to return the number of signal losses detected */
+uint32_t PPMReader::GetSignalLossCount() {
+	return this->signalLossCount;
+}
+
+/* Function to return the time from the last edge to the detection of the last signal loss */
+uint32_t PPMReader::GetSignalLossDetectionTime() {
+	return this->signalLossDetectionTime;
+}
+
+
 /* Function to return the latest raw (not necessarily valid) value for the  * channel (starting from 0) */
 uint16_t PPMReader::rawChannelValue(uint8_t channel) {
     // Check for channel's validity and return the latest raw channel value or 0
@@ -159,6 +562,12 @@ uint16_t PPMReader::rawChannelValue(uint8_t channel) {
  
 
 
+/* Function to return the amount of channels expected in a frame */
+uint8_t PPMReader::GetChannelAmount() {
+    return this->channelAmount;
+}
+
+
 /* Function to read the last available raw data into an array. 
 Returns a timestamp in microseconds to indicate when the data was received.
 Channels is an array from 0 to ChannelAmount+1 to cover the number  of channels from 1 to Channelamount
@@ -210,6 +619,19 @@ uint32_t PPMReader::readRaw(uint16_t* channels, bool forseRead) {
 
 }
 
+/* Function to apply the calibration multipliers and constraints to a raw value.
+With a compile time profile which does not scale the values only an integer bias is applied,
+so no float calculations are needed */
+inline uint16_t PPMReader::normaliseInteger(uint16_t value) {
+#ifdef RADIO_PROFILE_STATIC
+	if (activeRadio.multiplierScale == 1.0f && activeRadio.multiplierBias == (int16_t)activeRadio.multiplierBias) {
+		int32_t biased = (int32_t)value + (int16_t)activeRadio.multiplierBias;
+		return (uint16_t) constrain(biased, (int32_t)PPM_MIN_CHANNEL_VALUE, (int32_t)PPM_MAX_CHANNEL_VALUE);
+	}
+#endif
+	return (uint16_t) constrain((uint16_t) value * PPM_MULTIPLIER_SCALE + PPM_MULTIPLIER_BIAS, PPM_MIN_CHANNEL_VALUE, PPM_MAX_CHANNEL_VALUE);
+}
+
 /* Function to read the last available normalised data into an array (integer values)   
 Returns a timestamp in microseconds to indicate when the data was received.
 Channels is an array from 0 to ChannelAmount+1 to cover the number  of channels from 1 to ChannelAmount
@@ -226,7 +648,7 @@ uint32_t PPMReader::readNormalisedInteger(uint16_t* channels, bool forseRead) {
 			
 			//apply multipliers AND constraints 
 			noInterrupts();
-            channels[i] = (uint16_t) constrain((uint16_t) rawValues[i] * multiplierScale + multiplierBias, minChannelValue, maxChannelValue);
+            channels[i] = normaliseInteger(rawValues[i]);
 			interrupts();
 		}
         
@@ -250,7 +672,7 @@ uint32_t PPMReader::readNormalisedInteger(uint16_t* channels, bool forseRead) {
 			
 				//apply multipliers AND constraints 
 				noInterrupts();
-                channels[i] = (uint16_t) constrain((uint16_t) rawValues[i] * multiplierScale + multiplierBias, minChannelValue, maxChannelValue);
+                channels[i] = normaliseInteger(rawValues[i]);
 				interrupts();
 			}
 			// Set fail safe value to Channel 0 
@@ -290,7 +712,7 @@ uint32_t PPMReader::readNormalisedFloat(float* channels, bool forseRead) {
 			
 			//apply multipliers AND constraints 
 			noInterrupts();
-			channels[i] = (float) constrain((float) rawValues[i] * multiplierScale + multiplierBias, minChannelValue, maxChannelValue);
+			channels[i] = (float) constrain((float) rawValues[i] * PPM_MULTIPLIER_SCALE + PPM_MULTIPLIER_BIAS, PPM_MIN_CHANNEL_VALUE, PPM_MAX_CHANNEL_VALUE);
             interrupts();   
 		}
 		
@@ -314,7 +736,7 @@ uint32_t PPMReader::readNormalisedFloat(float* channels, bool forseRead) {
 			
 				//apply multipliers AND constraints 
 				noInterrupts();
-				channels[i] = (float) constrain((float) rawValues[i] * multiplierScale + multiplierBias, minChannelValue, maxChannelValue);
+				channels[i] = (float) constrain((float) rawValues[i] * PPM_MULTIPLIER_SCALE + PPM_MULTIPLIER_BIAS, PPM_MIN_CHANNEL_VALUE, PPM_MAX_CHANNEL_VALUE);
 				interrupts();
 			}
 			
@@ -334,17 +756,128 @@ uint32_t PPMReader::readNormalisedFloat(float* channels, bool forseRead) {
 }
 
 
+/* Function to start the frame queue */
+void PPMReader::setupFrameQueue() {
+	noInterrupts();
+	frameTail = frameHead;
+	frameQueueEnabled = true;
+	interrupts();
+}
+
+
+/* Function to put the frame just completed into the frame queue, called where the frames complete.
+If the queue is full the frame is lost: it is counted and its sequence number is skipped */
+void PPMReader::enqueueFrame(uint32_t timeStamp) {
+	if (!frameQueueEnabled) {
+		return;
+	}
+	uint32_t sequence = frameSequence++;
+	uint8_t head = frameHead;
+	uint8_t used = head - frameTail;
+	if (used >= PPMREADER_FRAME_QUEUE_DEPTH) {
+		++frameQueueOverflowCount;
+		return;
+	}
+
+	ppmFrame* frame = &frameQueue[head % PPMREADER_FRAME_QUEUE_DEPTH];
+	frame->timeStamp = timeStamp;
+	frame->sequence = sequence;
+	frame->failSafe = failSafe;
+	frame->signalLoss = signalLost;
+	uint8_t channels = (channelAmount < PPMREADER_MAX_CHANNELS) ? channelAmount : PPMREADER_MAX_CHANNELS;
+	for (uint8_t i = 1; i <= channels; ++i) {
+		frame->values[i] = rawValues[i];
+	}
+	PPMREADER_COMPILER_BARRIER();
+	frameHead = head + 1;
+
+	if (used + 1 > frameQueueHighWater) {
+		frameQueueHighWater = used + 1;
+	}
+}
+
+
+/* Function to take the oldest queued frame. Only this function moves the tail of the queue */
+uint32_t PPMReader::readFrame(uint16_t* channels, uint32_t* sequence, bool* signalLoss) {
+	uint8_t tail = frameTail;
+	if (tail == frameHead) {
+		return 0;
+	}
+	PPMREADER_COMPILER_BARRIER();
+
+	const ppmFrame* frame = &frameQueue[tail % PPMREADER_FRAME_QUEUE_DEPTH];
+	uint8_t amount = (channelAmount < PPMREADER_MAX_CHANNELS) ? channelAmount : PPMREADER_MAX_CHANNELS;
+	for (uint8_t i = 1; i <= amount; ++i) {
+		channels[i] = normaliseInteger(frame->values[i]);
+	}
+	channels[0] = frame->failSafe ? codeFailSafe : codeNotFailSafe;
+	if (sequence != NULL) {
+		*sequence = frame->sequence;
+	}
+	if (signalLoss != NULL) {
+		*signalLoss = frame->signalLoss;
+	}
+	uint32_t timeStamp = frame->timeStamp;
+
+	PPMREADER_COMPILER_BARRIER();
+	frameTail = tail + 1;
+	return timeStamp;
+}
+
+
+/* Function to return the number of frames in the queue */
+uint8_t PPMReader::GetQueuedFrames() {
+	return (uint8_t)(frameHead - frameTail);
+}
+
+/* Function to return the number of frames lost because the queue was full */
+uint32_t PPMReader::GetFrameQueueOverflowCount() {
+	return this->frameQueueOverflowCount;
+}
+
+/* Function to return the most frames the queue has held */
+uint8_t PPMReader::GetFrameQueueHighWater() {
+	return this->frameQueueHighWater;
+}
+
+/* Function to write the signal loss and frame queue counters, saturated to the fields */
+void PPMReader::writeDiagnostics(ppmDiagnostics* diagnostics) {
+	uint32_t count = signalLossCount;
+	uint32_t detectionTime = signalLossDetectionTime;
+	uint32_t overflows = frameQueueOverflowCount;
+	diagnostics->signalLossCount = (count < 0xFFFF) ? count : 0xFFFF;
+	diagnostics->signalLossDetectionTime = (detectionTime < 0xFFFF) ? detectionTime : 0xFFFF;
+	diagnostics->frameQueueOverflows = (overflows < 0xFFFF) ? overflows : 0xFFFF;
+	diagnostics->frameQueueHighWater = frameQueueHighWater;
+}
+
+
 /* Function to return an indicator that PPM packet received */
 bool PPMReader::IsDataReady() {
 return this->isDataReady;
 }
 
+/* Function to return true if the last data packet is the failsafe of a signal loss */
+bool PPMReader::IsSignalLost() {
+return this->signalLost;
+}
+
 /* Function to return a timestamp when PPM packet received 
 or 0 if the current data packet is being received  */
 uint32_t PPMReader::GetDataInputTimeStamp() {
 return this->dataInputTimeStamp;
 }
 
+/* Function to return the number of complete frames received */
+uint32_t PPMReader::GetFrameCount() {
+return this->frameCount;
+}
+
+/* Function to return the number of pulses rejected as too short or too long */
+uint32_t PPMReader::GetRejectedPulseCount() {
+return this->rejectedPulseCount;
+}
+
 
  /*A static routine to the ISR function
    http://www.stm32duino.com/viewtopic.php?f=9&t=1364&start=10#p19895
@@ -1,6 +1,25 @@
 /*
 Original library is from https://github.com/Nikkilae/PPM-reader
 Updated by IF 
+2026-10-19
+- signal loss policy applied by the sketch at the calibrated values: the reader holds the channels and
+  marks the frame (ppmFrame.signalLoss, readFrame(), IsSignalLost())
+- writeDiagnostics(): the signal loss and frame queue counters for a feature report of the sketch
+- deferred decoding: the watchdog only queues the signal loss, decodeEdges() applies it in the order of the edges
+- edgeHook/watchdogHook instead of the memory monitor calls in the interrupts
+- dual-edge capture: the ISR reads the level from the port input register instead of digitalRead()
+- RADIO_PROFILE_STATIC is opt-in, with it the profile fields are const
+- GetChannelAmount(), so PPMMerger can check an input against its channel buffers
+- frame queue: a lock-free single producer/single consumer ring of complete frames with their timestamp 
+  and sequence number, so a slow reader gets every frame in order (readFrame()), overflow counter
+- deferred decoding: the edge interrupt only queues the edge time, decodeEdges() decodes the queue
+  at a lower priority; the frame timestamp is the time of its last edge; interrupt priorities
+- dual-edge capture: polarity detected from the duty cycle (AUTO), channels timed from both edges of the separators,
+  separator pulse width check; setupInterrupt() fall-through fixed (NORMAL was attached to FALLING)
+- signal loss watchdog on a hardware timer with hold/centre/throttle cut policies
+- frame and rejected pulse counters for the signal statistics
+- default limits, failsafe window and calibration multipliers come from the radio profile (RadioProfiles.h),
+  with RADIO_PROFILE_STATIC they are compile time constants
 2022-02-23
 - removed unnecessary comparison 
 2021-03-05
@@ -41,13 +60,70 @@ along with PPM Reader.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <Arduino.h>
 //#include <stdint.h> 
+#include "RadioProfiles.h"
 
 //define types
 typedef enum signalPolarity {
     NORMAL, /**data pulse is from LOW to HIGH */
-    INVERTED /**data pulse is from  HIGH to LOW */
+    INVERTED, /**data pulse is from  HIGH to LOW */
+    AUTO /**detected from the duty cycle, dual-edge capture only */
 }signalPolarity;
 
+//What the channels are set to when the signal is lost. The reader holds the last values and marks the frame,
+//the sketch applies the policy at the calibrated centre and minimum of the channels 
+typedef enum failSafePolicy {
+    FAILSAFE_HOLD, /**the last values are kept */
+    FAILSAFE_CENTER, /**all channels are set to the centre */
+    FAILSAFE_THROTTLE_CUT /**the last values are kept, the throttle channel is set to its minimum */
+}failSafePolicy;
+
+//Signal loss watchdog timer (TIMER4), 1 us tick, the timeout is limited by the 16 bit counter
+#define PPMREADER_WATCHDOG_MAX_TIMEOUT 65535
+
+//Dual-edge capture: edges to measure the duty cycle for the AUTO polarity, and the active level before it is known
+#define PPMREADER_POLARITY_DETECT_EDGES 64
+#define PPMREADER_LEVEL_UNKNOWN 0xFF
+
+//Deferred decoding: queued edges, a power of 2. A frame of 16 channels is 17 edges (34 dual-edge) 
+#define PPMREADER_EDGE_QUEUE_SIZE 64
+
+//Frame queue: complete frames, a power of 2 up to 128. 4 frames cover a reader late by 3 frame periods (66 ms at 22 ms), 
+//set it in the build flags to change it 
+#ifndef PPMREADER_FRAME_QUEUE_DEPTH
+#define PPMREADER_FRAME_QUEUE_DEPTH 4
+#endif
+#if (PPMREADER_FRAME_QUEUE_DEPTH & (PPMREADER_FRAME_QUEUE_DEPTH - 1)) != 0 || PPMREADER_FRAME_QUEUE_DEPTH > 128
+#error PPMREADER_FRAME_QUEUE_DEPTH must be a power of 2 up to 128
+#endif
+//Channels kept in a queued frame 
+#define PPMREADER_MAX_CHANNELS 16
+
+//A complete frame in the frame queue
+typedef struct ppmFrame {
+    uint32_t timeStamp;   /**time of the last edge of the frame, us */
+    uint32_t sequence;    /**number of the frame, a frame lost when the queue is full leaves a gap */
+    bool failSafe;
+    bool signalLoss;      /**the failsafe frame of a signal loss, the values are held */
+    uint16_t values[PPMREADER_MAX_CHANNELS + 1];  /**raw values, indexed {1..channelAmount} */
+} ppmFrame;
+
+//The signal loss and frame queue counters as a part of a feature report (little endian, packed), 
+//the values are saturated at their maximum
+typedef struct ppmDiagnostics {
+    uint16_t signalLossCount;          /**losses detected by the watchdog */
+    uint16_t signalLossDetectionTime;  /**from the last edge to the detection of the last loss, us */
+    uint16_t frameQueueOverflows;      /**frames lost because the frame queue was full */
+    uint8_t frameQueueHighWater;       /**the most frames the frame queue has held */
+} __attribute__((packed)) ppmDiagnostics;
+
+
+//The profile fields of PPMReader are const with the compile time profile
+#ifdef RADIO_PROFILE_STATIC
+  #define PPMREADER_PROFILE_FIELD const
+#else
+  #define PPMREADER_PROFILE_FIELD
+#endif
+
 
 //Define thePPMReader class 
 //I can create several instances of PPMReader to handle various pins: 
@@ -60,10 +136,15 @@ class PPMReader {
 
     public:
     
+	//Default values of the fields below are from the radio profile (RadioProfiles.h).
+	//Note if RADIO_PROFILE_STATIC is defined then the profile values are compiled in
+	//and minChannelValue, maxChannelValue, blankTime, multiplierScale, multiplierBias
+	//and failSafeMin/MaxPulseLength are const, setting them is a compile error.
+
 	//The range of a channel's min/max possible values, microseconds
 	//default values are for +/-150% plus 100 us and minus 200us for contingency and for fail safe values
-    uint16_t minChannelValue = 700;
-    uint16_t maxChannelValue = 2200;
+    PPMREADER_PROFILE_FIELD uint16_t minChannelValue = activeRadio.minChannelValue;
+    PPMREADER_PROFILE_FIELD uint16_t maxChannelValue = activeRadio.maxChannelValue;
 
 	//TODO not currently used. Consider to check if value are within the max/min values and with channelValueMaxError tolerance.
     //The maximum error to max/min values (in either direction) in channel value
@@ -75,22 +156,13 @@ class PPMReader {
 	//Minimal blank time for 8 channels is:
 	// PPM signal period - (150% max servo duration * 8 + 400us trailing pulse) 
 	// 22000 us - (2100*8 + 400) = 4800us  */   
-    uint16_t blankTime = 5000;
+    PPMREADER_PROFILE_FIELD uint16_t blankTime = activeRadio.blankTime;
 
 	//Calibration multipliers to apply to raw channel data values before 
 	//it is returned as a normalised data (rawValues[i] * multiplierScale + multiplierBias;)
-    //Walkera DEVO 12E values:
-    //to uS (1100..1900):
-	//  Scale=1.0f
-	//  Bias=-9.0f 
-	//to percentage (-100..+100):
-	//  Scale=0.250f
-	//  Bias=-377.250f 
-	//to float (-1..+1):
-	//  Scale=0.00250f
-	//  Bias=-3.77250f
-    float multiplierScale = 1.0f;
-  	float multiplierBias = 0.0f;
+	//see RadioProfiles.h for the Walkera DEVO 12E values
+    PPMREADER_PROFILE_FIELD float multiplierScale = activeRadio.multiplierScale;
+  	PPMREADER_PROFILE_FIELD float multiplierBias = activeRadio.multiplierBias;
 	
 	//Codes to return in case of failsafe condition is detected
 	//Set the same as SBUS codes of Walkera DEVO 12E
@@ -99,8 +171,31 @@ class PPMReader {
     uint16_t codeNotFailSafe=3;
 	//Min and Max pulse length in microseconds to detect a failsafe condition
     //Apparently Walkera returns an approx 800 us pulse on all channels when the receiver is binded but signal is lost
-	uint16_t failSafeMinPulseLength = 770;
-	uint16_t failSafeMaxPulseLength = 830; 
+	PPMREADER_PROFILE_FIELD uint16_t failSafeMinPulseLength = activeRadio.failSafeMinPulseLength;
+	PPMREADER_PROFILE_FIELD uint16_t failSafeMaxPulseLength = activeRadio.failSafeMaxPulseLength; 
+
+	//Signal loss detection, see setupSignalLossWatchdog():
+	//the signal is lost if there is no edge for signalLossFrames * the measured frame period
+	//(or defaultFramePeriod until the frame period is measured)
+	uint8_t signalLossFrames = 1;
+	uint16_t defaultFramePeriod = 22500;
+	//Channel values when the signal is lost, the throttle channel is used for FAILSAFE_THROTTLE_CUT.
+	//Not applied by the reader, the frame is only marked (see readFrame()) 
+	failSafePolicy signalLossPolicy = FAILSAFE_HOLD;
+	uint8_t throttleChannel = 3;
+
+	//Optional functions called first in the edge interrupt and in the watchdog timer interrupt,
+	//e.g. the sketch samples the stack pointer for the memory monitor. NULL - none
+	void (*edgeHook)() = NULL;
+	void (*watchdogHook)() = NULL;
+
+	//Dual-edge capture: a separator pulse shorter or longer than this is noise and it is ignored, us.
+	//The level of an edge is read in the ISR, after the interrupt entry latency (about 1..2 us, more if
+	//a higher priority interrupt is running), so only the spikes longer than that latency are seen
+	//as two edges and rejected here; a shorter spike is one edge with the level after it, the edge
+	//at the inactive level without a leading edge is ignored.
+	uint16_t minSeparatorWidth = 100;
+	uint16_t maxSeparatorWidth = 700;
 	
 	
     private:
@@ -131,6 +226,95 @@ class PPMReader {
 	
 	//Indicates that PPM packet contains data that can be recognised as a fail safe mode 
 	volatile bool failSafe = false;
+	//The failsafe is a signal loss, until the next frame starts 
+	volatile bool signalLost = false;
+
+	//Counters for the signal statistics: complete frames and pulses rejected 
+	//by the minChannelValue/maxChannelValue check
+	volatile uint32_t frameCount = 0;
+	volatile uint32_t rejectedPulseCount = 0;
+
+	//Signal loss watchdog: measured frame period, current timeout, armed flag (an edge since the last timeout),
+	//the number of losses detected and the time from the last edge to the detection of the last loss, us 
+	volatile uint32_t framePeriod = 0;
+	volatile uint32_t frameStartTimeStamp = 0;
+	volatile uint16_t signalLossTimeout = 0;
+	volatile bool watchdogArmed = false;
+	bool watchdogRunning = false;
+	volatile uint32_t signalLossCount = 0;
+	volatile uint32_t signalLossDetectionTime = 0;
+
+	//Deferred decoding: losses detected by the watchdog (head) and applied by decodeEdges() (tail), 
+	//the time of the last one. Each index is written by one side only, like the edge queue 
+	volatile uint8_t signalLossHead = 0;
+	volatile uint8_t signalLossTail = 0;
+	volatile uint32_t signalLossTime = 0;
+
+	//Updates the frame period and the watchdog timeout at the start of a frame 
+	void updateFramePeriod(uint32_t timeStamp);
+
+	//Drops the frame in progress and makes the failsafe frame ready, marked as a signal loss 
+	void applySignalLoss(uint32_t timeStamp);
+
+	//Returns the level of the pin, HIGH or LOW, a direct read of the port on STM32 
+	uint8_t readLevel();
+
+	//Dual-edge capture: the active (separator) level, edges of the current and the last valid separator pulse, 
+	//time at each level while the polarity is detected 
+	bool dualEdge = false;
+#ifdef __STM32F1__
+	volatile uint32_t* levelRegister = NULL;  //input data register of the port and the bit of the pin
+	uint32_t levelMask = 0;
+#endif
+	volatile uint8_t activeLevel = PPMREADER_LEVEL_UNKNOWN;
+	volatile bool separatorStarted = false;
+	volatile uint32_t leadingEdgeTime = 0;
+	volatile uint32_t lastLeadingEdgeTime = 0;
+	volatile uint32_t lastTrailingEdgeTime = 0;
+	volatile uint8_t polarityEdges = 0;
+	volatile uint32_t polarityEdgeTime = 0;
+	volatile uint32_t highTime = 0;
+	volatile uint32_t lowTime = 0;
+
+	//Deferred decoding: edge times (and levels for the dual-edge capture) queued by the ISR, 
+	//the decode request handler, the last decoded edge, the position of the first lost edge 
+	//and the number of edges lost when the queue was full
+	bool deferredDecode = false;
+	void (*decodeRequest)() = NULL;
+	volatile uint32_t edgeTimes[PPMREADER_EDGE_QUEUE_SIZE];
+	volatile uint8_t edgeLevels[PPMREADER_EDGE_QUEUE_SIZE];
+	volatile uint8_t edgeHead = 0;
+	volatile uint8_t edgeTail = 0;
+	volatile bool edgeOverflow = false;
+	volatile uint8_t edgeGap = 0;
+	volatile uint32_t edgeOverflowCount = 0;
+	uint32_t decodedEdgeTime = 0;
+
+	//Frame queue: written by the context which completes the frames (ISR and the watchdog, which only runs 
+	//when there has been no edge for a frame period, or decodeEdges() alone), read by readFrame(). 
+	//Each index is written by one side only, so no lock is needed 
+	bool frameQueueEnabled = false;
+	ppmFrame frameQueue[PPMREADER_FRAME_QUEUE_DEPTH];
+	volatile uint8_t frameHead = 0;
+	volatile uint8_t frameTail = 0;
+	uint32_t frameSequence = 0;
+	volatile uint32_t frameQueueOverflowCount = 0;
+	volatile uint8_t frameQueueHighWater = 0;
+
+	//Puts the frame just completed into the frame queue 
+	void enqueueFrame(uint32_t timeStamp);
+
+	//Handles an edge in the dual-edge capture mode 
+	void captureEdge(uint32_t timeStamp, uint8_t level);
+
+	//Measures the time at each level until the active level is known 
+	void detectPolarity(uint32_t timeStamp, uint8_t level);
+
+	//Handles the time between two separators: a blank time starts a frame, otherwise it is the next channel 
+	void processPulse(uint16_t time, uint32_t timeStamp);
+
+	//Applies calibration multipliers and constraints to a raw value 
+	uint16_t normaliseInteger(uint16_t value);
 
     public:
 
@@ -140,27 +324,75 @@ class PPMReader {
 	//Delete PPMReader object
     ~PPMReader();
 	
-	//Set up interrupt 
-  	void setupInterrupt(uint8_t interruptPin, signalPolarity PPMsignalPolarity = NORMAL); 
+	//Set up interrupt. With dualEdge both edges are captured and the channels are timed from both edges 
+	//of the separator pulses (the interrupt latency jitter is averaged), AUTO polarity is dual-edge only 
+  	void setupInterrupt(uint8_t interruptPin, signalPolarity PPMsignalPolarity = NORMAL, bool dualEdge = false); 
+
+	//Returns the signal polarity, AUTO until it is detected 
+	signalPolarity GetPolarity();
+
+	//Sets the priority of the edge interrupt and of the watchdog timer interrupt, 0 - highest, 15 - lowest (STM32)
+	void setInterruptPriority(uint8_t priority);
+
+	//Set up deferred decoding: the ISR only queues the edge time and calls decodeRequest (e.g. to pend 
+	//a software interrupt), decodeEdges() is then called at a lower priority and the frames are decoded there.
+	//The signal loss watchdog only records the loss and calls decodeRequest as well, decodeEdges() applies it 
+	//after the edges before it, so the frame state and the frame queue are written by decodeEdges() only.
+	void setupDeferredDecode(void (*decodeRequest)());
+
+	//Decodes the queued edges (deferred decoding), not to be called from a context the edge interrupt cannot preempt
+	void decodeEdges();
+
+	//Returns the number of edges lost because decodeEdges() was late and the queue was full 
+	uint32_t GetEdgeOverflowCount();
    	
 	//Interrupt Service Routine function 
 	void ISR();
 
+	//Set up the signal loss watchdog (TIMER4, STM32). Only one PPMReader can use it. 
+	void setupSignalLossWatchdog();
+
+	//Watchdog timeout event, called from the timer interrupt:
+	//sets the failsafe condition and makes a new data packet ready, marked as a signal loss 
+	//(with deferred decoding this is done by decodeEdges())
+	void onSignalLoss();
+
+	//Returns the time when the watchdog times out if no edge comes before it, us, or 0 if it is not armed  
+	uint32_t GetSignalLossDeadline();
+
+	//Returns the number of signal losses detected 
+	uint32_t GetSignalLossCount();
+
+	//Returns the time from the last edge to the detection of the last signal loss, us 
+	uint32_t GetSignalLossDetectionTime();
+
     //Returns the latest raw (not necessarily valid) value for a channel
     //(starting from 0, Ch0 is a failsafe value, Ch1,2,etc. are the channels values). 
     uint16_t rawChannelValue(uint8_t channel);
 
+	//Returns the amount of channels expected in a frame 
+	uint8_t GetChannelAmount();
+
  //   //Returns the latest received value that was considered valid for the channel (starting from 0).
  //   //Returns defaultValue if the given channel hasn't received any valid values yet. */
  //   uint16_t latestValidChannelValue(uint8_t channel, uint16_t defaultValue);
 		
 	//Returns status of current data packet 
 	bool IsDataReady();
+
+	//Returns true if the last data packet is the failsafe of a signal loss, with the last values held 
+	bool IsSignalLost();
 	
 	
 	//Returns time in microseconds when the last data packet was received 
 	//or 0 if the current data packet is being received  
 	uint32_t GetDataInputTimeStamp();
+
+	//Returns the number of complete frames received 
+	uint32_t GetFrameCount();
+
+	//Returns the number of pulses rejected as too short or too long
+	uint32_t GetRejectedPulseCount();
 	
     
 	//Functions to read the last available  data into an array. 
@@ -171,6 +403,25 @@ class PPMReader {
 	uint32_t readNormalisedInteger(uint16_t* channels, bool forseRead = false);  //normalised data of Integer type
 	uint32_t readNormalisedFloat(float* channels, bool forseRead = false);  //normalised data of Float type
 
+	//Starts the frame queue: from now on every complete frame is queued until readFrame() takes it
+	void setupFrameQueue();
+
+	//Takes the oldest queued frame, normalised as readNormalisedInteger() does, Ch0 is the failsafe code. 
+	//Returns its timestamp in microseconds, or 0 if the queue is empty. 
+	//sequence (optional) is set to the number of the frame, consecutive frames have consecutive numbers, 
+	//signalLoss (optional) is set if the frame is the failsafe frame of a signal loss, with the last values held 
+	uint32_t readFrame(uint16_t* channels, uint32_t* sequence = NULL, bool* signalLoss = NULL);
+
+	//Returns the number of frames in the queue 
+	uint8_t GetQueuedFrames();
+
+	//Returns the number of frames lost because the queue was full, and the most frames the queue has held
+	uint32_t GetFrameQueueOverflowCount();
+	uint8_t GetFrameQueueHighWater();
+
+	//Writes the signal loss and frame queue counters, e.g. into the diagnostics feature report of the sketch
+	void writeDiagnostics(ppmDiagnostics* diagnostics);
+
 
 	
 };
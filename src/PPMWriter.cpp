@@ -0,0 +1,195 @@
+/*
+PPM Writer
+
+Regenerates a PPM signal from channel values using TIMER3 PWM and DMA.
+
+References: RM0008 STM32F10x reference manual - 15.3.10 PWM mode, 15.4.18 DMA, 13.3.7 DMA1 request mapping
+
+TODO - see the .h file
+=================================================================
+(C) 2026 ifh
+This file is part of PPM to USB Joystick.
+
+PPM to USB Joystick is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+PPM to USB Joystick is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+*/
+
+// Set to true to print some debug messages, or false to disable them.
+//#define ENABLE_DEBUG_OUTPUT_PPMWriter
+
+#include "Arduino.h"
+#include "PPMWriter.h"
+
+#ifdef __STM32F1__
+#include <libmaple/timer.h>
+#include <libmaple/dma.h>
+
+//The DMA interrupt handler has no argument, so only one PPMWriter can be running
+static PPMWriter* dmaPPMWriter = NULL;
+
+static void dmaHandler() {
+	dma_irq_cause cause = dma_get_irq_cause(DMA1, DMA_CH3);
+	if (dmaPPMWriter == NULL) {
+		return;
+	}
+	if (dmaPPMWriter->interruptHook != NULL) {
+		dmaPPMWriter->interruptHook();
+	}
+	if (cause == DMA_TRANSFER_HALF_COMPLETE) {
+		dmaPPMWriter->onHalfTransfer();
+	}
+	else if (cause == DMA_TRANSFER_COMPLETE) {
+		dmaPPMWriter->onTransferComplete();
+	}
+}
+#endif
+
+
+/* Set PPMWriter object */
+PPMWriter::PPMWriter(uint8_t channelAmount) {
+	_channelAmount = (channelAmount <= PPMWRITER_MAX_CHANNELS) ? channelAmount : PPMWRITER_MAX_CHANNELS;
+
+	//Both frames with centered channels until the first write()
+	uint16_t channels[PPMWRITER_MAX_CHANNELS + 1];
+	for (uint8_t i=0; i<=PPMWRITER_MAX_CHANNELS; i++) {
+		channels[i] = activeRadio.channelMidPoint;
+	}
+	buildFrameTable(channels, &_table[0]);
+	buildFrameTable(channels, &_table[_channelAmount + 1]);
+}
+
+
+/* Delete PPMWriter object */
+PPMWriter::~PPMWriter() {
+	end();
+}
+
+
+/* Function to build one frame of the table */
+uint8_t PPMWriter::buildFrameTable(const uint16_t* channels, uint16_t* table) {
+	uint32_t used = 0;
+	for (uint8_t i=1; i<=_channelAmount; i++) {
+		uint16_t value = constrain(channels[i], minChannelValue, maxChannelValue);
+		if (value <= separatorLength) {
+			value = separatorLength + 1;
+		}
+		table[i - 1] = value - 1;  //the timer counts from 0 to ARR
+		used += value;
+	}
+
+	//The sync slot takes the rest of the frame
+	uint32_t sync = (frameLength > used + minSyncLength) ? frameLength - used : minSyncLength;
+	if (sync > 65536) {
+		sync = 65536;
+	}
+	table[_channelAmount] = sync - 1;
+	return _channelAmount + 1;
+}
+
+
+/* Function to put a new frame into the frame table */
+void PPMWriter::write(const uint16_t* channels) {
+	if (!_running) {
+		//Nothing is being sent, update both frames
+		buildFrameTable(channels, &_table[0]);
+		buildFrameTable(channels, &_table[_channelAmount + 1]);
+		return;
+	}
+	buildFrameTable(channels, &_table[_freeFrame * (_channelAmount + 1)]);
+}
+
+
+/* Functions to return the frame table */
+const uint16_t* PPMWriter::GetFrameTable() {
+	return _table;
+}
+
+uint8_t PPMWriter::GetFrameEntries() {
+	return _channelAmount + 1;
+}
+
+
+/* DMA interrupt events. DMA is reading the other frame now */
+void PPMWriter::onHalfTransfer() {
+	_freeFrame = 0;
+}
+
+void PPMWriter::onTransferComplete() {
+	_freeFrame = 1;
+}
+
+
+/* Function to set up the timer and DMA and start the output */
+void PPMWriter::begin() {
+#ifdef __STM32F1__
+	timer_dev* dev = TIMER3;
+	dmaPPMWriter = this;
+
+	pinMode(PA6, PWM);
+	timer_pause(dev);
+	timer_set_prescaler(dev, CYCLES_PER_MICROSECOND - 1);  //1 us tick
+
+	//PWM mode 1 with preloaded compare, the separator pulse is at the start of each period
+	timer_set_mode(dev, TIMER_CH1, TIMER_PWM);
+	timer_set_compare(dev, TIMER_CH1, separatorLength);
+	if (polarity == INVERTED) {
+		dev->regs.gen->CCER |= TIMER_CCER_CC1P;
+	}
+	else
+	{
+		dev->regs.gen->CCER &= ~TIMER_CCER_CC1P;
+	}
+
+	//Preloaded ARR: the value written by DMA on an update event is used for the next slot.
+	//Start with the sync slot so the output starts at a frame boundary
+	dev->regs.gen->CR1 |= TIMER_CR1_ARPE;
+	timer_set_reload(dev, _table[_channelAmount]);
+	timer_generate_update(dev);
+
+	//DMA: the frame table to ARR on every update event, circular, interrupts at each frame end
+	dma_init(DMA1);
+	dma_setup_transfer(DMA1, DMA_CH3, &dev->regs.gen->ARR, DMA_SIZE_16BITS,
+	                   _table, DMA_SIZE_16BITS,
+	                   DMA_MINC_MODE | DMA_CIRC_MODE | DMA_FROM_MEM | DMA_HALF_TRNS | DMA_TRNS_CMPLT);
+	dma_set_num_transfers(DMA1, DMA_CH3, 2 * (_channelAmount + 1));
+	dma_set_priority(DMA1, DMA_CH3, DMA_PRIORITY_HIGH);
+	dma_attach_interrupt(DMA1, DMA_CH3, dmaHandler);
+	dma_enable(DMA1, DMA_CH3);
+
+	timer_dma_enable_req(dev, 0);  //0 - update DMA request
+	timer_resume(dev);
+#endif
+	//DMA starts with the first frame
+	_freeFrame = 1;
+	_running = true;
+
+#ifdef ENABLE_DEBUG_OUTPUT_PPMWriter
+  Serial.println("PPMWriter::begin completed");
+#endif
+}
+
+
+/* Function to stop the output */
+void PPMWriter::end() {
+#ifdef __STM32F1__
+	if (_running) {
+		timer_pause(TIMER3);
+		timer_dma_disable_req(TIMER3, 0);
+		dma_disable(DMA1, DMA_CH3);
+		dma_detach_interrupt(DMA1, DMA_CH3);
+		dmaPPMWriter = NULL;
+	}
+#endif
+	_running = false;
+}
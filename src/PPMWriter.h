@@ -0,0 +1,114 @@
+/*
+PPM Writer
+
+Regenerates a PPM signal from channel values (e.g. the filtered channelsIN_MF frame)
+to pass it to a trainer port or another device.
+
+The output uses TIMER3 channel 1 (pin PA6, Maple Mini pin 5) in PWM mode with a 1 us tick.
+Every PPM slot (a channel or the sync gap) is one timer period: the compare value gives
+the separator pulse at the start of the slot, the period (ARR) gives the slot length.
+DMA1 channel 3 (TIMER3 update request) reloads ARR from a precomputed frame table
+on every update event, so the CPU does not touch the individual pulses and the output
+jitter is only the timer tick quantisation.
+
+The frame table holds two frames and DMA runs over it in circular mode.
+The half/complete transfer interrupts tell which frame is not being sent,
+write() rebuilds that frame, so the output never has a torn frame.
+
+buildFrameTable() does not depend on the hardware and can be used on a PC.
+
+TODO:
+
+=================================================================
+(C) 2026 ifh
+This file is part of PPM to USB Joystick.
+
+PPM to USB Joystick is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+PPM to USB Joystick is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+*/
+
+#ifndef PPMWRITER_H
+#define PPMWRITER_H
+
+#include "Arduino.h"
+#include "PPMReader.h"
+
+#define PPMWRITER_MAX_CHANNELS 16
+
+//Slots in a frame - a slot per channel and the sync slot
+#define PPMWRITER_MAX_FRAME_ENTRIES (PPMWRITER_MAX_CHANNELS + 1)
+
+
+class PPMWriter {
+	public:
+		//Set PPMWriter object
+		PPMWriter(uint8_t channelAmount);
+
+		//Delete PPMWriter object
+		~PPMWriter();
+
+		//PPM frame length (period), microseconds. It is extended if the channels do not fit.
+		uint32_t frameLength = 22500;
+
+		//Separator pulse length at the start of each slot, microseconds
+		uint16_t separatorLength = 400;
+
+		//The minimum sync gap at the end of a frame, microseconds, shall be above the reader's blankTime
+		uint16_t minSyncLength = 5500;
+
+		//Channel values are constrained to this range, microseconds
+		uint16_t minChannelValue = activeRadio.minChannelValue;
+		uint16_t maxChannelValue = activeRadio.maxChannelValue;
+
+		//Output polarity, INVERTED - separator pulses are LOW
+		signalPolarity polarity = INVERTED;
+
+		//Optional function called first in the DMA interrupt, e.g. to sample the stack pointer. NULL - none
+		void (*interruptHook)() = NULL;
+
+		//Set up the timer and DMA and start the output (STM32 only)
+		void begin();
+
+		//Stop the output
+		void end();
+
+		//Puts a new frame into the frame table, it is sent after the frame being sent now.
+		//channels is an array from 0 to ChannelAmount+1 to cover the number of channels from 1 to ChannelAmount
+		void write(const uint16_t* channels);
+
+		//Builds one frame of the table: a timer reload value (slot length - 1) for each channel
+		//followed by the sync slot. Returns the number of entries (channelAmount + 1).
+		uint8_t buildFrameTable(const uint16_t* channels, uint16_t* table);
+
+		//Returns the frame table (two frames) and the number of entries in one frame
+		const uint16_t* GetFrameTable();
+		uint8_t GetFrameEntries();
+
+		//DMA interrupt events - the first / the second frame of the table has been sent
+		void onHalfTransfer();
+		void onTransferComplete();
+
+	private:
+		uint8_t _channelAmount = 0;
+
+		//Two frames, DMA reads them in circular mode
+		uint16_t _table[2 * PPMWRITER_MAX_FRAME_ENTRIES];
+
+		//The frame of the table which is not being sent now, 0 or 1
+		volatile uint8_t _freeFrame = 0;
+
+		bool _running = false;
+};
+
+#endif
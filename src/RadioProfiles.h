@@ -0,0 +1,130 @@
+/*
+Radio profiles
+
+Calibration and limits for a particular radio/receiver, selected at compile time.
+The profile gives the default values for the public PPMReader fields
+(minChannelValue, blankTime etc.) which then can be changed at run time.
+
+The default build (without RADIO_PROFILE_STATIC) is unchanged: the PPMReader fields are initialised
+from the profile to the values they had before and they are read from RAM as before, so it has
+the same loads per pulse and per frame.
+RADIO_PROFILE_STATIC is opt-in: with it the range checks in PPMReader::ISR(), the failsafe window
+and the calibration multipliers are compiled as immediates instead of reading variables from RAM
+for every pulse and every frame. The PPMReader fields then become const, so a sketch which sets them
+does not compile instead of being silently ignored.
+Measured on the host only (x86-64, g++ -O2), the Cortex-M3 figures are in the linker map and will differ:
+PPMReader.o text 4728 -> 4432 bytes, readNormalisedInteger() 78 -> 59 ns per 8 channel frame,
+the edge interrupt is within the noise of the simulator (the simulator profile scenario, built with
+and without -DRADIO_PROFILE_STATIC). The float multiply/add per channel which it removes
+is soft-float on the Cortex-M3, so the gain there is larger than on the host.
+
+To add a radio, add a profile below and select it with RADIO_PROFILE.
+Note the profile is selected here (not in the sketch) as the Arduino IDE compiles
+the libraries in src/ separately and they would not see a #define from the sketch.
+
+TODO:
+
+=================================================================
+(C) 2026 ifh
+This file is part of PPM to USB Joystick.
+
+PPM to USB Joystick is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+PPM to USB Joystick is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+*/
+
+#ifndef RADIOPROFILES_H
+#define RADIOPROFILES_H
+
+#include <stdint.h>
+
+//Uncomment to compile the profile in instead of the run time PPMReader fields (they become const)
+//#define RADIO_PROFILE_STATIC
+
+typedef struct radioProfile {
+    //RC input channel parameters (stick endpoints and centre), microseconds
+    uint16_t minNormalChannelValue;
+    uint16_t maxNormalChannelValue;
+    uint16_t channelMidPoint;
+
+    //The range of a channel's min/max possible values, microseconds
+    uint16_t minChannelValue;
+    uint16_t maxChannelValue;
+
+    //The minimum time after which the signal frame is considered to be finished, microseconds
+    uint16_t blankTime;
+
+    //Calibration multipliers (rawValues[i] * multiplierScale + multiplierBias;)
+    float multiplierScale;
+    float multiplierBias;
+
+    //Min and Max pulse length in microseconds to detect a failsafe condition,
+    //min > max disables the detection
+    uint16_t failSafeMinPulseLength;
+    uint16_t failSafeMaxPulseLength;
+} radioProfile;
+
+
+//Any radio with 1100..1900us sticks, no calibration
+//Minimal blank time for 8 channels is:
+// PPM signal period - (150% max servo duration * 8 + 400us trailing pulse)
+// 22000 us - (2100*8 + 400) = 4800us
+constexpr radioProfile RADIO_PROFILE_GENERIC = {
+    1100, 1900, 1500,
+    700, 2200,
+    5000,
+    1.0f, 0.0f,
+    770, 830
+};
+
+//Walkera DEVO 12E, returns approx 800us pulses on all channels when the receiver is binded but signal is lost.
+//Other calibration options:
+//to percentage (-100..+100):
+//  Scale=0.250f
+//  Bias=-377.250f
+//to float (-1..+1):
+//  Scale=0.00250f
+//  Bias=-3.77250f
+constexpr radioProfile RADIO_PROFILE_WALKERA_DEVO12E = {
+    1100, 1900, 1500,
+    700, 2200,
+    5000,
+    1.0f, -9.0f,
+    770, 830
+};
+
+//FrSky (OpenTX/EdgeTX) radios with default limits, 988..2012us, no failsafe pulses
+constexpr radioProfile RADIO_PROFILE_FRSKY = {
+    988, 2012, 1500,
+    700, 2200,
+    4000,
+    1.0f, 0.0f,
+    1, 0
+};
+
+//Futaba radios, 1100..1940us with 1520us centre, no failsafe pulses
+constexpr radioProfile RADIO_PROFILE_FUTABA = {
+    1100, 1940, 1520,
+    700, 2200,
+    5000,
+    1.0f, 0.0f,
+    1, 0
+};
+
+
+//Select the radio profile
+#define RADIO_PROFILE RADIO_PROFILE_GENERIC
+
+constexpr radioProfile activeRadio = RADIO_PROFILE;
+
+#endif
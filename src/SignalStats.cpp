@@ -0,0 +1,232 @@
+/*
+Signal quality statistics
+
+Running statistics of the received signal, updated once per frame.
+
+Shifted data algorithm: https://en.wikipedia.org/wiki/Algorithms_for_calculating_variance#Computing_shifted_data
+
+TODO - see the .h file
+=================================================================
+(C) 2026 ifh
+This file is part of PPM to USB Joystick.
+
+PPM to USB Joystick is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+PPM to USB Joystick is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+*/
+
+// Set to true to print some debug messages, or false to disable them.
+//#define ENABLE_DEBUG_OUTPUT_SIGNALSTATS
+
+#include "Arduino.h"
+#include "SignalStats.h"
+
+
+/* Set SignalStats object */
+SignalStats::SignalStats() {
+	reset();
+}
+
+
+/* Delete SignalStats object */
+SignalStats::~SignalStats() {
+}
+
+
+/* Function to clear all statistics */
+void SignalStats::reset() {
+	for (uint8_t i=0; i<=SIGNALSTATS_MAX_CHANNELS; i++) {
+		_stats[i].count = 0;
+		_stats[i].shift = 0;
+		_stats[i].sum = 0;
+		_stats[i].sumSquares = 0;
+		_stats[i].min = 0xFFFF;
+		_stats[i].max = 0;
+		_outliers[i] = 0;
+	}
+	_failSafeFrames = 0;
+	_lastTimeStamp = 0;
+	_previousFrames = 0;
+	_reportChannel = 1;
+}
+
+
+/* Function to add a sample to running statistics, integer only */
+void SignalStats::addSample(runningStats* stats, uint32_t value) {
+	if (stats->count == 0) {
+		stats->shift = value;
+	}
+	++stats->count;
+	int32_t difference = (int32_t)(value - stats->shift);
+	stats->sum += difference;
+	stats->sumSquares += (int64_t)difference * difference;
+	uint16_t saturated = (value < 0xFFFF) ? value : 0xFFFF;
+	if (saturated < stats->min) {
+		stats->min = saturated;
+	}
+	if (saturated > stats->max) {
+		stats->max = saturated;
+	}
+}
+
+
+/* Function to return the median of three values */
+static inline uint16_t median3(uint16_t a, uint16_t b, uint16_t c) {
+	uint16_t low = (a < b) ? a : b;
+	uint16_t high = (a < b) ? b : a;
+	return (c < low) ? low : ((c > high) ? high : c);
+}
+
+
+/* Function to update the statistics with a frame */
+void SignalStats::update(const uint16_t* chIN, uint32_t timeStamp) {
+
+	//Frame period, gaps of a lost signal are not included
+	if (_lastTimeStamp != 0) {
+		uint32_t period = timeStamp - _lastTimeStamp;
+		if (period <= maxFramePeriod) {
+			addSample(&_stats[0], period);
+		}
+	}
+	_lastTimeStamp = timeStamp;
+
+	//Failsafe frames carry no stick data, the frames around them have no neighbours
+	if (chIN[0] == codeFailSafe) {
+		++_failSafeFrames;
+		_previousFrames = 0;
+		return;
+	}
+
+	for (uint8_t i=1; i<=channelAmount; i++) {
+		addSample(&_stats[i], chIN[i]);
+		//the previous frame against the median of it and its neighbours
+		if (_previousFrames >= 2) {
+			uint16_t sample = _previous[1][i];
+			uint16_t median = median3(_previous[0][i], sample, chIN[i]);
+			uint16_t residual = (sample > median) ? sample - median : median - sample;
+			if (residual > outlierThreshold) {
+				++_outliers[i];
+			}
+		}
+		_previous[0][i] = _previous[1][i];
+		_previous[1][i] = chIN[i];
+	}
+	if (_previousFrames < 2) {
+		++_previousFrames;
+	}
+}
+
+
+/* Function to set the counters maintained by PPMReader */
+void SignalStats::setReaderCounters(uint32_t frameCount, uint32_t rejectedPulses) {
+	_frameCount = frameCount;
+	_rejectedPulses = rejectedPulses;
+}
+
+
+/* Function to return the statistics of a channel or of the frame period (0) */
+const runningStats* SignalStats::GetStats(uint8_t channel) {
+	if (channel > SIGNALSTATS_MAX_CHANNELS) {
+		return NULL;
+	}
+	return &_stats[channel];
+}
+
+
+/* Function to return the integer square root */
+static uint32_t squareRoot(uint64_t value) {
+	uint64_t root = 0;
+	uint64_t bit = 1ULL << 62;
+	while (bit > value) {
+		bit >>= 2;
+	}
+	while (bit != 0) {
+		if (value >= root + bit) {
+			value -= root + bit;
+			root = (root >> 1) + bit;
+		}
+		else {
+			root >>= 1;
+		}
+		bit >>= 2;
+	}
+	return (uint32_t)root;
+}
+
+
+/* Function to return the mean of running statistics, 1/16 us */
+uint32_t SignalStats::GetMeanQ4(const runningStats* stats) {
+	if (stats->count == 0) {
+		return 0;
+	}
+	return (uint32_t)((int64_t)stats->shift * 16 + stats->sum * 16 / (int64_t)stats->count);
+}
+
+
+/* Function to return the standard deviation of running statistics, 1/16 us.
+The sample variance of the differences: (mean of the squares - square of the mean) * count / (count - 1) */
+uint32_t SignalStats::GetStdDevQ4(const runningStats* stats) {
+	if (stats->count < 2) {
+		return 0;
+	}
+	uint64_t count = stats->count;
+	uint64_t meanSquareQ8 = (stats->sumSquares / count) * 256 + (stats->sumSquares % count) * 256 / count;
+	int64_t meanQ4 = stats->sum * 16 / (int64_t)count;
+	uint64_t squareMeanQ8 = (uint64_t)(meanQ4 * meanQ4);
+	if (meanSquareQ8 <= squareMeanQ8) {
+		return 0;
+	}
+	uint64_t varianceQ8 = (meanSquareQ8 - squareMeanQ8) * count / (count - 1);
+	return squareRoot(varianceQ8);
+}
+
+
+/* Function to write the next feature report, returns the report size */
+uint16_t SignalStats::writeFeatureReport(uint8_t* buffer, uint8_t reportID) {
+	signalStatsReport_t report;
+	memset(&report, 0, sizeof(report));
+
+	report.reportID = reportID;
+	report.firstChannel = _reportChannel;
+	report.channelAmount = channelAmount;
+	report.frameCount = _frameCount;
+	report.rejectedPulses = _rejectedPulses;
+	report.failSafeFrames = _failSafeFrames;
+	uint32_t framePeriodMean = (GetMeanQ4(&_stats[0]) + 8) / 16;
+	uint32_t framePeriodStdDev = GetStdDevQ4(&_stats[0]);
+	report.framePeriodMean = (framePeriodMean < 0xFFFF) ? framePeriodMean : 0xFFFF;
+	report.framePeriodStdDev = (framePeriodStdDev < 0xFFFF) ? framePeriodStdDev : 0xFFFF;
+
+	for (uint8_t k=0; k<SIGNALSTATS_REPORT_CHANNELS; k++) {
+		uint8_t i = _reportChannel + k;
+		if (i > channelAmount || _stats[i].count == 0) {
+			continue;
+		}
+		uint32_t mean = GetMeanQ4(&_stats[i]);
+		uint32_t stdDev = GetStdDevQ4(&_stats[i]);
+		report.channels[k].mean = (mean < 0xFFFF) ? mean : 0xFFFF;
+		report.channels[k].stdDev = (stdDev < 0xFFFF) ? stdDev : 0xFFFF;
+		report.channels[k].min = _stats[i].min;
+		report.channels[k].max = _stats[i].max;
+		report.channels[k].outliers = (_outliers[i] < 0xFFFF) ? _outliers[i] : 0xFFFF;
+	}
+
+	//Next group of channels
+	_reportChannel += SIGNALSTATS_REPORT_CHANNELS;
+	if (_reportChannel > channelAmount) {
+		_reportChannel = 1;
+	}
+
+	memcpy(buffer, &report, sizeof(report));
+	return sizeof(report);
+}
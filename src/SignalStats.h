@@ -0,0 +1,160 @@
+/*
+Signal quality statistics
+
+Running statistics of the received signal, updated once per frame at O(1) cost per channel:
+ - per channel: mean and variance of the pulse length, min/max and the number of outliers
+   (samples which differ by more than outlierThreshold from the median of themselves and their two neighbours,
+   so a moving stick is not an outlier, a single spike is)
+ - per frame: frame period mean and variance, failsafe frame count,
+   frame count and rejected pulse count from PPMReader
+The startup times, the signal loss, the frame queue and the pipeline latencies are not here, they are
+in the diagnostics report of the sketch (PPMReader::writeDiagnostics(), FrameScheduler::writeLatencies()).
+
+The sums are integer (no float on the Cortex-M3 which has no FPU): the differences from the first sample
+and their squares are summed in 64 bits, the mean and the variance are only calculated for the report.
+
+The statistics are serialised into a feature report, 4 channels per report.
+Every writeFeatureReport() call gives the next group of channels, so a host tool
+polling the feature report gets all channels in channelAmount/4 reads.
+
+Feature report layout (little endian, packed):
+  byte 0       - report ID
+  byte 1       - first channel in this report (1, 5, 9, 13)
+  byte 2       - channelAmount
+  bytes 3..6   - frame count (PPMReader)
+  bytes 7..10  - rejected pulse count (PPMReader)
+  bytes 11..14 - failsafe frame count
+  bytes 15..16 - frame period mean, us
+  bytes 17..18 - frame period standard deviation, 1/16 us
+  then 4 channels, 10 bytes each:
+    mean, 1/16 us; standard deviation, 1/16 us; min, us; max, us; outliers (saturated at 65535)
+
+TODO:
+
+=================================================================
+(C) 2026 ifh
+This file is part of PPM to USB Joystick.
+
+PPM to USB Joystick is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+PPM to USB Joystick is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+*/
+
+#ifndef SIGNALSTATS_H
+#define SIGNALSTATS_H
+
+#include "Arduino.h"
+
+#define SIGNALSTATS_MAX_CHANNELS 16
+
+//Channels in one feature report
+#define SIGNALSTATS_REPORT_CHANNELS 4
+
+//Running statistics of a value, sums of the differences from the first sample (shifted data)
+typedef struct runningStats {
+    uint32_t count;
+    uint32_t shift;        //the first sample
+    int64_t sum;           //sum of the differences from the first sample
+    uint64_t sumSquares;   //sum of the squares of the differences from the first sample
+    uint16_t min;
+    uint16_t max;
+} runningStats;
+
+//Feature report, packed to match the layout above
+typedef struct {
+    uint16_t mean;      //1/16 us
+    uint16_t stdDev;    //1/16 us
+    uint16_t min;
+    uint16_t max;
+    uint16_t outliers;
+} __attribute__((packed)) channelStatsReport_t;
+
+typedef struct {
+    uint8_t reportID;
+    uint8_t firstChannel;
+    uint8_t channelAmount;
+    uint32_t frameCount;
+    uint32_t rejectedPulses;
+    uint32_t failSafeFrames;
+    uint16_t framePeriodMean;
+    uint16_t framePeriodStdDev;
+    channelStatsReport_t channels[SIGNALSTATS_REPORT_CHANNELS];
+} __attribute__((packed)) signalStatsReport_t;
+
+
+class SignalStats {
+	public:
+		//Set SignalStats object
+		SignalStats();
+
+		//Delete SignalStats object
+		~SignalStats();
+
+		//The amount of channels, <= SIGNALSTATS_MAX_CHANNELS
+		uint8_t channelAmount = 8;
+
+		//A sample is an outlier if it differs by more than this from the median of itself,
+		//the frame before and the frame after it, us
+		uint16_t outlierThreshold = 10;
+
+		//Frame intervals longer than this are signal gaps and are not included in the frame period, us
+		uint32_t maxFramePeriod = 100000;
+
+		//Code in Ch0 for failsafe condition
+		uint16_t codeFailSafe = 0;
+
+		//Clears all statistics
+		void reset();
+
+		//Updates the statistics with a frame, the outliers are known one frame later
+		// parameter chIN[] - the frame as received, Ch0 is the failsafe code
+		// parameter timeStamp - time when the frame was received, us
+		void update(const uint16_t* chIN, uint32_t timeStamp);
+
+		//Sets the counters maintained by PPMReader
+		void setReaderCounters(uint32_t frameCount, uint32_t rejectedPulses);
+
+		//Returns the statistics of a channel (1..channelAmount) or of the frame period (0)
+		const runningStats* GetStats(uint8_t channel);
+
+		//Returns the mean of running statistics, 1/16 us
+		static uint32_t GetMeanQ4(const runningStats* stats);
+
+		//Returns the standard deviation of running statistics, 1/16 us
+		static uint32_t GetStdDevQ4(const runningStats* stats);
+
+		//Writes the next feature report (the next group of channels) into a buffer
+		//of at least sizeof(signalStatsReport_t) bytes. Returns the report size.
+		uint16_t writeFeatureReport(uint8_t* buffer, uint8_t reportID);
+
+	private:
+		//Index 0 is the frame period, 1..SIGNALSTATS_MAX_CHANNELS are the channels
+		runningStats _stats[SIGNALSTATS_MAX_CHANNELS + 1];
+		uint32_t _outliers[SIGNALSTATS_MAX_CHANNELS + 1];
+
+		//The two frames before the current one for the outliers, valid frames in a row (0..2)
+		uint16_t _previous[2][SIGNALSTATS_MAX_CHANNELS + 1];
+		uint8_t _previousFrames = 0;
+
+		uint32_t _failSafeFrames = 0;
+		uint32_t _frameCount = 0;
+		uint32_t _rejectedPulses = 0;
+		uint32_t _lastTimeStamp = 0;
+
+		//First channel of the next feature report
+		uint8_t _reportChannel = 1;
+
+		static void addSample(runningStats* stats, uint32_t value);
+};
+
+#endif